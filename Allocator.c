@@ -0,0 +1,220 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "Allocator.h"
+
+
+// The counters are atomic because the shared heap allocator serves concurrent parses
+typedef struct
+{
+   Allocator_t interface;
+   AllocatorHooks_t hooks;
+   bool shared;
+   atomic_size_t allocations;
+   atomic_size_t releases;
+   atomic_size_t liveBytes;
+   atomic_size_t peakBytes;
+} Implementation;
+
+
+static void countAllocation( Implementation *impl, size_t oldSize, size_t newSize )
+{
+size_t live, peak;
+
+   atomic_fetch_add_explicit( &impl-> allocations, 1, memory_order_relaxed );
+   live = atomic_fetch_add_explicit( &impl-> liveBytes, newSize - oldSize, memory_order_relaxed ) + newSize - oldSize;
+   peak = atomic_load_explicit( &impl-> peakBytes, memory_order_relaxed );
+   while( live > peak && !atomic_compare_exchange_weak_explicit( &impl-> peakBytes, &peak, live, memory_order_relaxed, memory_order_relaxed ) )
+   {
+   }
+}
+
+
+static void * mallocHook( void *userData, size_t size )
+{
+   ( void ) userData;
+
+   return malloc( size );
+}
+
+
+static void * reallocHook( void *userData, void *ptr, size_t oldSize, size_t newSize )
+{
+   ( void ) userData;
+   ( void ) oldSize;
+
+   return realloc( ptr, newSize );
+}
+
+
+static void freeHook( void *userData, void *ptr, size_t size )
+{
+   ( void ) userData;
+   ( void ) size;
+
+   free( ptr );
+}
+
+
+static void * allocate( const Allocator_t *self, size_t size )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+void *ptr;
+
+   if( ( ptr = impl-> hooks.allocate( impl-> hooks.userData, size ) ) != NULL )
+   {
+      memset( ptr, 0, size );
+      countAllocation( impl, 0, size );
+   }
+
+   return ptr;
+}
+
+
+static void * reallocate( const Allocator_t *self, void *ptr, size_t oldSize, size_t newSize )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+void *tmp;
+
+   if( ptr == NULL )
+   {
+      oldSize = 0;
+      tmp = impl-> hooks.allocate( impl-> hooks.userData, newSize );
+   }
+   else
+   {
+      tmp = impl-> hooks.reallocate( impl-> hooks.userData, ptr, oldSize, newSize );
+   }
+
+   if( tmp != NULL )
+   {
+      countAllocation( impl, oldSize, newSize );
+   }
+
+   return tmp;
+}
+
+
+static char * duplicate( const Allocator_t *self, const char *str )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+size_t size;
+char *copy;
+
+   if( str == NULL )
+   {
+      return NULL;
+   }
+
+   size = strlen( str ) + 1;
+   if( ( copy = impl-> hooks.allocate( impl-> hooks.userData, size ) ) != NULL )
+   {
+      memcpy( copy, str, size );
+      countAllocation( impl, 0, size );
+   }
+
+   return copy;
+}
+
+
+static void release( const Allocator_t *self, void *ptr, size_t size )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( ptr != NULL )
+   {
+      impl-> hooks.release( impl-> hooks.userData, ptr, size );
+      atomic_fetch_add_explicit( &impl-> releases, 1, memory_order_relaxed );
+      atomic_fetch_sub_explicit( &impl-> liveBytes, size, memory_order_relaxed );
+   }
+}
+
+
+static void releaseString( const Allocator_t *self, char *str )
+{
+   if( str != NULL )
+   {
+      release( self, str, strlen( str ) + 1 );
+   }
+}
+
+
+static bool isArena( const Allocator_t *self )
+{
+   ( void ) self;
+
+   return false;
+}
+
+
+static void getStats( const Allocator_t *self, AllocatorStats_t *stats )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   stats-> allocations = atomic_load_explicit( &impl-> allocations, memory_order_relaxed );
+   stats-> releases = atomic_load_explicit( &impl-> releases, memory_order_relaxed );
+   stats-> liveBytes = atomic_load_explicit( &impl-> liveBytes, memory_order_relaxed );
+   stats-> peakBytes = atomic_load_explicit( &impl-> peakBytes, memory_order_relaxed );
+   stats-> reservedBytes = stats-> liveBytes;
+}
+
+
+static void delete( Allocator_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   if( !impl-> shared )
+   {
+      free( impl );
+   }
+   *selfPtr = NULL;
+}
+
+
+static Implementation heap =
+{
+   { allocate, reallocate, duplicate, release, releaseString, isArena, getStats, delete },
+   { mallocHook, reallocHook, freeHook, NULL },
+   true, 0, 0, 0, 0
+};
+
+
+const Allocator_t * heapAllocator( void )
+{
+   return &heap.interface;
+}
+
+
+Allocator_t * newAllocator( const AllocatorHooks_t *hooks )
+{
+Implementation *self;
+
+   if( hooks != NULL && ( hooks-> allocate == NULL || hooks-> reallocate == NULL || hooks-> release == NULL ) )
+   {
+      return NULL;
+   }
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   self-> hooks = hooks != NULL ? *hooks : heap.hooks;
+   self-> interface.allocate = allocate;
+   self-> interface.reallocate = reallocate;
+   self-> interface.duplicate = duplicate;
+   self-> interface.release = release;
+   self-> interface.releaseString = releaseString;
+   self-> interface.isArena = isArena;
+   self-> interface.getStats = getStats;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
@@ -0,0 +1,259 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "Allocator.h"
+
+
+#define ARENA_DEFAULT_BLOCK_SIZE   ( 64 * 1024 )
+#define ARENA_ALIGNMENT            _Alignof( max_align_t )
+#define ARENA_ROUND( size )        ( ( ( size ) + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 ) )
+
+
+typedef struct Block
+{
+   struct Block *next;
+   size_t size;
+   size_t used;
+} Block;
+
+
+typedef struct
+{
+   Allocator_t interface;
+   // Lazy commands load, and help is rendered, while other threads parse, so the tree's allocator may be called
+   // from several threads at once
+   pthread_mutex_t lock;
+   Block *blocks;
+   size_t blockSize;
+   AllocatorStats_t stats;
+} Implementation;
+
+
+static void countBytes( Implementation *impl, size_t bytes )
+{
+   impl-> stats.liveBytes += bytes;
+   if( impl-> stats.liveBytes > impl-> stats.peakBytes )
+   {
+      impl-> stats.peakBytes = impl-> stats.liveBytes;
+   }
+}
+
+
+static char * blockData( Block *block )
+{
+   return ( char * ) block + ARENA_ROUND( sizeof( Block ) );
+}
+
+
+static void * bump( Implementation *impl, size_t size )
+{
+size_t rounded = ARENA_ROUND( size );
+Block *block;
+char *ptr;
+
+   impl-> stats.allocations++;
+   if( impl-> blocks != NULL && impl-> blocks-> size - impl-> blocks-> used >= rounded )
+   {
+      ptr = blockData( impl-> blocks ) + impl-> blocks-> used;
+      impl-> blocks-> used += rounded;
+      countBytes( impl, rounded );
+      return ptr;
+   }
+
+   if( ( block = malloc( ARENA_ROUND( sizeof( Block ) ) + ( rounded > impl-> blockSize ? rounded : impl-> blockSize ) ) ) == NULL )
+   {
+      impl-> stats.allocations--;
+      return NULL;
+   }
+
+   block-> size = rounded > impl-> blockSize ? rounded : impl-> blockSize;
+   block-> used = rounded;
+   impl-> stats.reservedBytes += ARENA_ROUND( sizeof( Block ) ) + block-> size;
+   countBytes( impl, rounded );
+
+   // Oversized requests get a block of their own behind the current one, which keeps bumping
+   if( impl-> blocks != NULL && rounded > impl-> blockSize / 4 )
+   {
+      block-> next = impl-> blocks-> next;
+      impl-> blocks-> next = block;
+   }
+   else
+   {
+      block-> next = impl-> blocks;
+      impl-> blocks = block;
+   }
+
+   return blockData( block );
+}
+
+
+// True when ptr..ptr+size is the most recent allocation in the current block, so it can be given back or grown in place
+static bool isTop( const Implementation *impl, const void *ptr, size_t size )
+{
+   return impl-> blocks != NULL && impl-> blocks-> used >= ARENA_ROUND( size ) && ( const char * ) ptr == blockData( impl-> blocks ) + impl-> blocks-> used - ARENA_ROUND( size );
+}
+
+
+static void * allocate( const Allocator_t *self, size_t size )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+void *ptr;
+
+   pthread_mutex_lock( &impl-> lock );
+   ptr = bump( impl, size );
+   pthread_mutex_unlock( &impl-> lock );
+   if( ptr != NULL )
+   {
+      memset( ptr, 0, size );
+   }
+
+   return ptr;
+}
+
+
+static void * reallocate( const Allocator_t *self, void *ptr, size_t oldSize, size_t newSize )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+void *tmp;
+
+   if( ptr != NULL && newSize <= oldSize )
+   {
+      return ptr;
+   }
+
+   pthread_mutex_lock( &impl-> lock );
+   if( ptr != NULL && isTop( impl, ptr, oldSize ) && impl-> blocks-> size - impl-> blocks-> used >= ARENA_ROUND( newSize ) - ARENA_ROUND( oldSize ) )
+   {
+      impl-> blocks-> used += ARENA_ROUND( newSize ) - ARENA_ROUND( oldSize );
+      impl-> stats.allocations++;
+      countBytes( impl, ARENA_ROUND( newSize ) - ARENA_ROUND( oldSize ) );
+      tmp = ptr;
+   }
+   else if( ( tmp = bump( impl, newSize ) ) != NULL && ptr != NULL )
+   {
+      memcpy( tmp, ptr, oldSize );
+   }
+   pthread_mutex_unlock( &impl-> lock );
+
+   return tmp;
+}
+
+
+static char * duplicate( const Allocator_t *self, const char *str )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+size_t size;
+char *copy;
+
+   if( str == NULL )
+   {
+      return NULL;
+   }
+
+   size = strlen( str ) + 1;
+   pthread_mutex_lock( &impl-> lock );
+   copy = bump( impl, size );
+   pthread_mutex_unlock( &impl-> lock );
+   if( copy != NULL )
+   {
+      memcpy( copy, str, size );
+   }
+
+   return copy;
+}
+
+
+// Individual releases are no-ops except for the most recent allocation, so short-lived LIFO objects do not accumulate
+static void release( const Allocator_t *self, void *ptr, size_t size )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( ptr == NULL )
+   {
+      return;
+   }
+
+   pthread_mutex_lock( &impl-> lock );
+   impl-> stats.releases++;
+   if( isTop( impl, ptr, size ) )
+   {
+      impl-> blocks-> used -= ARENA_ROUND( size );
+      impl-> stats.liveBytes -= ARENA_ROUND( size );
+   }
+   pthread_mutex_unlock( &impl-> lock );
+}
+
+
+static void releaseString( const Allocator_t *self, char *str )
+{
+   if( str != NULL )
+   {
+      release( self, str, strlen( str ) + 1 );
+   }
+}
+
+
+static bool isArena( const Allocator_t *self )
+{
+   ( void ) self;
+
+   return true;
+}
+
+
+// Bytes stay live until the arena goes unless they were the most recent allocation; reservedBytes counts whole blocks
+static void getStats( const Allocator_t *self, AllocatorStats_t *stats )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   pthread_mutex_lock( &impl-> lock );
+   *stats = impl-> stats;
+   pthread_mutex_unlock( &impl-> lock );
+}
+
+
+static void delete( Allocator_t **selfPtr )
+{
+Implementation *impl;
+Block *block, *next;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   for( block = impl-> blocks; block != NULL; block = next )
+   {
+      next = block-> next;
+      free( block );
+   }
+   pthread_mutex_destroy( &impl-> lock );
+   free( impl );
+   *selfPtr = NULL;
+}
+
+
+Allocator_t * newArenaAllocator( size_t blockSize )
+{
+Implementation *self;
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   pthread_mutex_init( &self-> lock, NULL );
+   self-> blockSize = blockSize != 0 ? ARENA_ROUND( blockSize ) : ARENA_DEFAULT_BLOCK_SIZE;
+   self-> interface.allocate = allocate;
+   self-> interface.reallocate = reallocate;
+   self-> interface.duplicate = duplicate;
+   self-> interface.release = release;
+   self-> interface.releaseString = releaseString;
+   self-> interface.isArena = isArena;
+   self-> interface.getStats = getStats;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
@@ -3,14 +3,15 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "Argument.h"
+#include "Allocator.h"
 
 
 typedef struct
 {
    Argument_t interface;
+   const Allocator_t *allocator;
    char *name;
    char *description;
-   char *value;
    bool required;
 } Implementation;
 
@@ -43,20 +44,6 @@ Implementation *impl;
 }
 
 
-static const char * getValue( const Argument_t *self )
-{
-Implementation *impl;
-
-   if( self == NULL )
-   {
-      return NULL;
-   }
-
-   impl = __containerof( self, Implementation, interface );
-   return impl-> value;
-}
-
-
 static bool isRequired( const Argument_t *self )
 {
 Implementation *impl;
@@ -71,27 +58,19 @@ Implementation *impl;
 }
 
 
-static void setValue( const Argument_t *self, const char *value )
+static void measure( const Argument_t *self, CLIMemoryReport_t *report )
 {
 Implementation *impl;
 
-   if( self == NULL )
+   if( self == NULL || report == NULL )
    {
       return;
    }
 
-   if( ( impl = __containerof( self, Implementation, interface ) ) != NULL )
-   {
-      free( impl-> value );
-   }
-   if( value != NULL )
-   {
-      impl-> value = strdup( value );
-   }
-   else
-   {
-      impl-> value = NULL;
-   }
+   impl = __containerof( self, Implementation, interface );
+   addMemoryUsage( &report-> arguments, sizeof( Implementation ) );
+   addStringUsage( report, impl-> name );
+   addStringUsage( report, impl-> description );
 }
 
 
@@ -106,45 +85,49 @@ Implementation *impl;
 
    if( ( impl = __containerof( *selfPtr, Implementation, interface ) ) != NULL )
    {
-      free( impl-> name );
-      free( impl-> description );
-      free( impl-> value );
-      free( impl );
+      impl-> allocator-> releaseString( impl-> allocator, impl-> description );
+      impl-> allocator-> releaseString( impl-> allocator, impl-> name );
+      impl-> allocator-> release( impl-> allocator, impl, sizeof( Implementation ) );
    }
    *selfPtr = NULL;
 }
 
 
-Argument_t * newArgument( const char *name, const char *description, bool required )
+Argument_t * newArgument( const Allocator_t *allocator, const char *name, const char *description, bool required )
 {
 Implementation *self;
 
-   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   if( allocator == NULL )
+   {
+      allocator = heapAllocator();
+   }
+
+   if( ( self = allocator-> allocate( allocator, sizeof( Implementation ) ) ) == NULL )
    {
       return NULL;
    }
 
-   if( ( self-> name = strdup( name ) ) == NULL )
+   self-> allocator = allocator;
+   if( ( self-> name = allocator-> duplicate( allocator, name ) ) == NULL )
    {
-      free( self );
+      allocator-> release( allocator, self, sizeof( Implementation ) );
       return NULL;
    }
 
    if( description != NULL )
    {
-      if( ( self-> description = strdup( description ) ) == NULL )
+      if( ( self-> description = allocator-> duplicate( allocator, description ) ) == NULL )
       {
-         free( self-> name );
-         free( self );
+         allocator-> releaseString( allocator, self-> name );
+         allocator-> release( allocator, self, sizeof( Implementation ) );
          return NULL;
       }
    }
    self-> required = required;
    self-> interface.getName = getName;
    self-> interface.getDescription = getDescription;
-   self-> interface.getValue = getValue;
    self-> interface.isRequired = isRequired;
-   self-> interface.setValue = setValue;
+   self-> interface.measure = measure;
    self-> interface.delete = delete;
 
    return &self-> interface;
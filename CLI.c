@@ -2,67 +2,51 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <time.h>
 #include "CLI.h"
 #include "Command.h"
 #include "Argument.h"
 #include "Flag.h"
+#include "Allocator.h"
+#include "Tokenizer.h"
+#include "ParallelBatch.h"
+#include "Server.h"
+#include "Timing.h"
+#include "Plugin.h"
 
 
 typedef struct
 {
    CLI_t interface;
+   Allocator_t *allocator;
    Command_t *rootCommand;
+   Plugins_t *plugins;
 } Implementation;
 
 
-static const char *findSubCmdToken = NULL;
-static Command_t *findSubCmdFound = NULL;
-
-
-static bool findSubCmd( Command_t *sub )
-{
-   if( strcmp( sub-> getName( sub ), findSubCmdToken ) == 0 )
-   {
-      findSubCmdFound = sub;
-      return false;
-   }
-
-   return true;
-}
-
-
+// Walks a space-separated path token by token straight out of the caller's string: no copy, no strtok state
 static Command_t * resolveCommandPath( Command_t *root, const char *path )
 {
-char *pathCopy;
-const char *token;
-Command_t *current;
+Command_t *current = root;
+size_t length;
 
-   if( root == NULL || path == NULL || *path == '\0' )
+   if( root == NULL || path == NULL )
    {
       return root;
    }
 
-   if( ( pathCopy = strdup( path ) ) == NULL )
+   while( current != NULL )
    {
-      return NULL;
-   }
-
-   token = strtok( pathCopy, " " );
-   current = root;
-   while( token != NULL && current != NULL )
-   {
-      findSubCmdToken = token;
-      findSubCmdFound = NULL;
-      current-> forEachSubCommand( current, findSubCmd );
-      current = findSubCmdFound;
-      if( current == NULL )
+      path += strspn( path, " " );
+      if( *path == '\0' )
       {
-         free( pathCopy );
-         return NULL;
+         break;
       }
-      token = strtok( NULL, " " );
+
+      length = strcspn( path, " " );
+      current = current-> findSubCommand( current, path, length );
+      path += length;
    }
-   free( pathCopy );
 
    return current;
 }
@@ -73,7 +57,7 @@ static int addCommand( const CLI_t *self, const char *name, const char *descript
 Implementation *impl = __containerof( self, Implementation, interface );
 Command_t *cmd;
 
-   if( ( cmd = newCommand( name, description, handler ) ) == NULL )
+   if( ( cmd = newCommand( impl-> allocator, name, description, handler ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
@@ -105,7 +89,7 @@ Command_t *parent, *sub;
       }
    }
 
-   if( ( sub = newCommand( name, description, handler ) ) == NULL )
+   if( ( sub = newCommand( impl-> allocator, name, description, handler ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
@@ -120,6 +104,53 @@ Command_t *parent, *sub;
 }
 
 
+// The command is listed in its parent's help and found by lookups at once; what lies below it is registered by the
+// loader when a parse, help or completion first reaches it
+static int addLazyCommand( const CLI_t *self, const char *parentPath, const char *name, const char *description, int ( *handler )( const CommandContext_t * ), CLILoader_t loader, void *userData )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+Command_t *parent, *cmd;
+
+   if( loader == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( parent = resolveCommandPath( impl-> rootCommand, parentPath ) ) == NULL )
+   {
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   if( ( cmd = newCommand( impl-> allocator, name, description, handler ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   setCommandLoader( cmd, loader, self, userData );
+   if( parent-> addSubCommand( parent, cmd ) != CLI_SUCCESS )
+   {
+      cmd-> delete( &cmd );
+      return CLI_ERROR_MEMORY;
+   }
+
+   return CLI_SUCCESS;
+}
+
+
+// Plugin commands are lazy commands whose loader opens the library, so the manifest costs one command per line
+static int loadPlugins( const CLI_t *self, const char *manifest )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( impl-> plugins == NULL && ( impl-> plugins = newPlugins() ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   return impl-> plugins-> load( impl-> plugins, self, manifest );
+}
+
+
 static int addArgument( const CLI_t *self, const char *path, const char *name, const char *description, bool required )
 {
 Implementation *impl = __containerof( self, Implementation, interface );
@@ -140,7 +171,7 @@ Argument_t *arg;
       return CLI_ERROR_NOT_FOUND;
    }
 
-   if( ( arg = newArgument( name, description, required ) ) == NULL )
+   if( ( arg = newArgument( impl-> allocator, name, description, required ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
@@ -175,7 +206,7 @@ Flag_t *flag;
       return CLI_ERROR_NOT_FOUND;
    }
 
-   if( ( flag = newFlag( name, shortName, description ) ) == NULL )
+   if( ( flag = newFlag( impl-> allocator, name, shortName, description ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
@@ -190,9 +221,383 @@ Flag_t *flag;
 }
 
 
-static int parse( const CLI_t *self, int argc, char *argv[] )
+// Registration goes through these, which while timing is enabled charge each call to the root's registration phase
+static int timedAddCommand( const CLI_t *self, const char *name, const char *description, int ( *handler )( const CommandContext_t * ) )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+uint64_t start;
+int result;
+
+   if( !isTimingEnabled() )
+   {
+      return addCommand( self, name, description, handler );
+   }
+
+   start = timingNow();
+   result = addCommand( self, name, description, handler );
+   recordTiming( impl-> rootCommand, TIMING_REGISTRATION, timingNow() - start );
+
+   return result;
+}
+
+
+static int timedAddSubCommand( const CLI_t *self, const char *parentPath, const char *name, const char *description, int ( *handler )( const CommandContext_t * ) )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+uint64_t start;
+int result;
+
+   if( !isTimingEnabled() )
+   {
+      return addSubCommand( self, parentPath, name, description, handler );
+   }
+
+   start = timingNow();
+   result = addSubCommand( self, parentPath, name, description, handler );
+   recordTiming( impl-> rootCommand, TIMING_REGISTRATION, timingNow() - start );
+
+   return result;
+}
+
+
+static int timedAddLazyCommand( const CLI_t *self, const char *parentPath, const char *name, const char *description, int ( *handler )( const CommandContext_t * ), CLILoader_t loader, void *userData )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+uint64_t start;
+int result;
+
+   if( !isTimingEnabled() )
+   {
+      return addLazyCommand( self, parentPath, name, description, handler, loader, userData );
+   }
+
+   start = timingNow();
+   result = addLazyCommand( self, parentPath, name, description, handler, loader, userData );
+   recordTiming( impl-> rootCommand, TIMING_REGISTRATION, timingNow() - start );
+
+   return result;
+}
+
+
+static int timedAddArgument( const CLI_t *self, const char *path, const char *name, const char *description, bool required )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+uint64_t start;
+int result;
+
+   if( !isTimingEnabled() )
+   {
+      return addArgument( self, path, name, description, required );
+   }
+
+   start = timingNow();
+   result = addArgument( self, path, name, description, required );
+   recordTiming( impl-> rootCommand, TIMING_REGISTRATION, timingNow() - start );
+
+   return result;
+}
+
+
+static int timedAddFlag( const CLI_t *self, const char *path, const char *name, char shortName, const char *description )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+uint64_t start;
+int result;
+
+   if( !isTimingEnabled() )
+   {
+      return addFlag( self, path, name, shortName, description );
+   }
+
+   start = timingNow();
+   result = addFlag( self, path, name, shortName, description );
+   recordTiming( impl-> rootCommand, TIMING_REGISTRATION, timingNow() - start );
+
+   return result;
+}
+
+
+static int getMemoryReport( const CLI_t *self, CLIMemoryReport_t *report )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( report == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   memset( report, 0, sizeof( CLIMemoryReport_t ) );
+   impl-> rootCommand-> measure( impl-> rootCommand, report );
+   sumMemoryReport( report );
+   getContextUsage( &report-> contexts );
+   impl-> allocator-> getStats( impl-> allocator, &report-> allocator );
+
+   return CLI_SUCCESS;
+}
+
+
+static int saveSnapshot( const CLI_t *self, const char *path, uint64_t tree, const CLIHandlerBinding_t *bindings, int bindingCount )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   return writeSnapshot( impl-> rootCommand, path, tree, bindings, bindingCount );
+}
+
+
+static int reserve( const CLI_t *self, const char *path, int subCommands, int arguments, int flags )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+Command_t *cmd;
+
+   if( ( cmd = resolveCommandPath( impl-> rootCommand, path ) ) == NULL )
+   {
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   return cmd-> reserve( cmd, subCommands, arguments, flags );
+}
+
+
+// Handles are positions in the command's lists, which only ever grow at the end, so one stays valid for the life of
+// the tree and indexes the parse context directly
+static int getArgumentId( const CLI_t *self, const char *path, const char *name )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+Command_t *cmd;
+int index;
+
+   if( name == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( cmd = resolveCommandPath( impl-> rootCommand, path ) ) == NULL || ( index = cmd-> findArgument( cmd, name, strlen( name ) ) ) < 0 )
+   {
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   return index;
+}
+
+
+static int getFlagId( const CLI_t *self, const char *path, const char *name )
 {
 Implementation *impl = __containerof( self, Implementation, interface );
+Command_t *cmd;
+int index;
+
+   if( name == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( cmd = resolveCommandPath( impl-> rootCommand, path ) ) == NULL || ( index = cmd-> findFlag( cmd, name, strlen( name ) ) ) < 0 )
+   {
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   return index;
+}
+
+
+static int freeze( const CLI_t *self, bool compact )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   return impl-> rootCommand-> freeze( impl-> rootCommand, compact );
+}
+
+
+static double secondsSince( const struct timespec *start )
+{
+struct timespec now;
+
+   clock_gettime( CLOCK_MONOTONIC, &now );
+
+   return ( double )( now.tv_sec - start-> tv_sec ) + ( double )( now.tv_nsec - start-> tv_nsec ) / 1e9;
+}
+
+
+// Runs every delimiter-terminated command line of the stream through the same tree. Nothing is rebuilt between
+// lines: the tree holds no parse state and the line buffer and argv vector are reused.
+static int parseBatch( const CLI_t *self, FILE *stream, int delimiter, CLIBatchStats_t *stats )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+Command_t *root = impl-> rootCommand;
+Tokenizer_t *tokenizer;
+const char *const *argv;
+char *line = NULL;
+size_t lineCapacity = 0;
+unsigned long physical = 0;
+struct timespec start;
+CLIBatchStats_t local = { 0, 0, 0.0 };
+int argc, result, status = CLI_SUCCESS;
+
+   if( stream == NULL || root == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( tokenizer = newTokenizer( root-> getName( root ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   clock_gettime( CLOCK_MONOTONIC, &start );
+   // Errors name the line as it appears in the stream, blank lines included, as the parallel runner does
+   while( getdelim( &line, &lineCapacity, delimiter, stream ) > 0 )
+   {
+      physical++;
+      if( ( argc = tokenizer-> tokenize( tokenizer, line, &argv ) ) < 0 )
+      {
+         fprintf( stderr, "Error: Malformed batch line %lu\n", physical );
+         result = argc;
+      }
+      else if( argc == 1 )
+      {
+         continue;
+      }
+      else
+      {
+         result = root-> parse( root, argc, argv );
+      }
+
+      local.lines++;
+      if( result != CLI_SUCCESS )
+      {
+         local.failed++;
+         if( status == CLI_SUCCESS )
+         {
+            status = result;
+         }
+      }
+   }
+   local.seconds = secondsSince( &start );
+
+   free( line );
+   tokenizer-> delete( &tokenizer );
+
+   if( stats != NULL )
+   {
+      *stats = local;
+   }
+
+   return status;
+}
+
+
+static int parseBatchParallel( const CLI_t *self, FILE *stream, int delimiter, const CLIParallelOptions_t *options, CLIBatchStats_t *stats )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   return runParallelBatch( impl-> rootCommand, stream, delimiter, options, stats );
+}
+
+
+// Built-in '--batch FILE|- [--jobs N] [--unordered]' (newline-delimited) and '--batch0 ...' (NUL-delimited) modes
+static int runBatch( const CLI_t *self, int argc, const char *const argv[] )
+{
+CLIParallelOptions_t options = { 0, true, NULL, NULL };
+CLIBatchStats_t stats;
+FILE *stream;
+bool valid = argc >= 3;
+int delimiter, result;
+
+   for( int i = 3; valid && i < argc; i++ )
+   {
+      if( strcmp( argv[ i ], "--jobs" ) == 0 && i + 1 < argc && ( options.threads = atoi( argv[ i + 1 ] ) ) > 0 )
+      {
+         i++;
+      }
+      else if( strcmp( argv[ i ], "--unordered" ) == 0 )
+      {
+         options.ordered = false;
+      }
+      else
+      {
+         valid = false;
+      }
+   }
+
+   if( !valid )
+   {
+      fprintf( stderr, "Error: Usage: %s %s FILE|- [--jobs N] [--unordered]\n", argv[ 0 ], argv[ 1 ] );
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( strcmp( argv[ 2 ], "-" ) == 0 )
+   {
+      stream = stdin;
+   }
+   else if( ( stream = fopen( argv[ 2 ], "r" ) ) == NULL )
+   {
+      fprintf( stderr, "Error: Cannot open batch file '%s'\n", argv[ 2 ] );
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   delimiter = strcmp( argv[ 1 ], "--batch0" ) == 0 ? '\0' : '\n';
+   if( options.threads > 0 )
+   {
+      result = parseBatchParallel( self, stream, delimiter, &options, &stats );
+   }
+   else
+   {
+      result = parseBatch( self, stream, delimiter, &stats );
+   }
+
+   if( stream != stdin )
+   {
+      fclose( stream );
+   }
+
+   fprintf( stderr, "Batch: %lu lines, %lu failed, %.3f s, %.0f lines/s\n", stats.lines, stats.failed, stats.seconds, stats.seconds > 0.0 ? ( double ) stats.lines / stats.seconds : 0.0 );
+
+   return result;
+}
+
+
+static int serve( const CLI_t *self, const char *path, int workers )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   return runServer( impl-> rootCommand, path, workers );
+}
+
+
+// Built-in '--serve SOCKET [--workers N]' runs the daemon; '--connect SOCKET COMMAND...' is the matching client
+static int runDaemon( const CLI_t *self, int argc, const char *const argv[] )
+{
+int workers = 4;
+
+   // Reached only once the tree is built; runConnect serves a client before that
+   if( strcmp( argv[ 1 ], "--connect" ) == 0 )
+   {
+      return connectCommand( argc, argv );
+   }
+
+   if( !( argc == 3 || ( argc == 5 && strcmp( argv[ 3 ], "--workers" ) == 0 && ( workers = atoi( argv[ 4 ] ) ) > 0 ) ) )
+   {
+      fprintf( stderr, "Error: Usage: %s --serve SOCKET [--workers N]\n", argv[ 0 ] );
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   return serve( self, argv[ 2 ], workers );
+}
+
+
+static int parseTokens( const CLI_t *self, int argc, const char *const argv[] )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( argc > 1 && ( strcmp( argv[ 1 ], "--batch" ) == 0 || strcmp( argv[ 1 ], "--batch0" ) == 0 ) )
+   {
+      return runBatch( self, argc, argv );
+   }
+
+   if( argc > 2 && ( strcmp( argv[ 1 ], "--serve" ) == 0 || strcmp( argv[ 1 ], "--connect" ) == 0 ) )
+   {
+      return runDaemon( self, argc, argv );
+   }
 
    if( impl-> rootCommand != NULL && impl-> rootCommand-> parse != NULL )
    {
@@ -203,9 +608,17 @@ Implementation *impl = __containerof( self, Implementation, interface );
 }
 
 
+static int parse( const CLI_t *self, int argc, char *argv[] )
+{
+   return parseTokens( self, argc, ( const char *const * ) argv );
+}
+
+
 static void delete( CLI_t **selfPtr )
 {
 Implementation *impl;
+Allocator_t *allocator;
+Plugins_t *plugins;
 CLI_t *self;
 
    if( selfPtr == NULL || *selfPtr == NULL )
@@ -217,32 +630,82 @@ CLI_t *self;
 
    if( ( impl = __containerof( self, Implementation, interface ) ) != NULL )
    {
-      if( impl-> rootCommand != NULL )
+      allocator = impl-> allocator;
+      plugins = impl-> plugins;
+
+      // An arena holds the whole tree, so releasing it is the entire teardown
+      if( allocator-> isArena( allocator ) )
       {
-         impl-> rootCommand-> delete( &impl-> rootCommand );
+         allocator-> delete( &allocator );
+      }
+      else
+      {
+         if( impl-> rootCommand != NULL )
+         {
+            impl-> rootCommand-> delete( &impl-> rootCommand );
+         }
+         allocator-> release( allocator, impl, sizeof( Implementation ) );
+         allocator-> delete( &allocator );
+      }
+
+      // Libraries are closed last, once nothing can reach their handlers
+      if( plugins != NULL )
+      {
+         plugins-> delete( &plugins );
       }
-      free( impl );
    }
    *selfPtr = NULL;
 }
 
 
-CLI_t * newCLI( const char *description )
+CLI_t * newCLIWithAllocator( const char *description, Allocator_t *allocator )
 {
 Implementation *self;
 
-   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   if( allocator == NULL )
+   {
+      return NULL;
+   }
+
+   if( ( self = allocator-> allocate( allocator, sizeof( Implementation ) ) ) == NULL )
    {
+      allocator-> delete( &allocator );
       return NULL;
    }
 
-   self-> interface.addCommand = addCommand;
-   self-> interface.addSubCommand = addSubCommand;
-   self-> interface.addArgument = addArgument;
-   self-> interface.addFlag = addFlag;
+   self-> allocator = allocator;
+
+   loadTimingEnvironment();
+   self-> interface.addCommand = timedAddCommand;
+   self-> interface.addSubCommand = timedAddSubCommand;
+   self-> interface.addLazyCommand = timedAddLazyCommand;
+   self-> interface.addArgument = timedAddArgument;
+   self-> interface.addFlag = timedAddFlag;
+   self-> interface.loadPlugins = loadPlugins;
+   self-> interface.getArgumentId = getArgumentId;
+   self-> interface.getFlagId = getFlagId;
+   self-> interface.reserve = reserve;
+   self-> interface.freeze = freeze;
    self-> interface.parse = parse;
+   self-> interface.parseTokens = parseTokens;
+   self-> interface.parseBatch = parseBatch;
+   self-> interface.parseBatchParallel = parseBatchParallel;
+   self-> interface.serve = serve;
+   self-> interface.getMemoryReport = getMemoryReport;
+   self-> interface.saveSnapshot = saveSnapshot;
    self-> interface.delete = delete;
-   self-> rootCommand = newCommand( getprogname(), description, NULL );
+   if( ( self-> rootCommand = newCommand( allocator, getprogname(), description, NULL ) ) == NULL )
+   {
+      allocator-> release( allocator, self, sizeof( Implementation ) );
+      allocator-> delete( &allocator );
+      return NULL;
+   }
 
    return &self-> interface;
 }
+
+
+CLI_t * newCLI( const char *description )
+{
+   return newCLIWithAllocator( description, newAllocator( NULL ) );
+}
@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Server.h"
+#include "Socket.h"
+#include "CLI.h"
+
+
+static bool copyOut( int fd, size_t length, FILE *stream )
+{
+char chunk[ 8192 ];
+size_t n;
+
+   while( length > 0 )
+   {
+      n = length < sizeof( chunk ) ? length : sizeof( chunk );
+      if( !readFull( fd, chunk, n ) )
+      {
+         return false;
+      }
+      fwrite( chunk, 1, n, stream );
+      length -= n;
+   }
+
+   return true;
+}
+
+
+// Thin client for runServer(): sends argv, copies the captured output and error to the given streams (stdout and
+// stderr when NULL) and stores the handler's result. Needs no command tree, so it can run before newCLI.
+int clientRequest( const char *path, int argc, const char *const argv[], FILE *output, FILE *error, int *result )
+{
+struct sockaddr_un address;
+ServerRequestHeader_t request;
+ServerResponseHeader_t response;
+char *payload, *cursor;
+size_t size = 0;
+int fd;
+bool ok;
+
+   if( path == NULL || strlen( path ) >= sizeof( address.sun_path ) || argc < 1 || ( unsigned ) argc > SERVER_MAX_ARGC || argv == NULL || result == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   for( int i = 0; i < argc; i++ )
+   {
+      size += strlen( argv[ i ] ) + 1;
+   }
+   if( size > SERVER_MAX_REQUEST )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( payload = malloc( sizeof( request ) + size ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   request.magic = SERVER_PROTOCOL_MAGIC;
+   request.argc = ( uint32_t ) argc;
+   request.size = ( uint32_t ) size;
+   memcpy( payload, &request, sizeof( request ) );
+   cursor = payload + sizeof( request );
+   for( int i = 0; i < argc; i++ )
+   {
+   size_t length = strlen( argv[ i ] ) + 1;
+
+      memcpy( cursor, argv[ i ], length );
+      cursor += length;
+   }
+
+   memset( &address, 0, sizeof( address ) );
+   address.sun_family = AF_UNIX;
+   strcpy( address.sun_path, path );
+
+   if( ( fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 || connect( fd, ( struct sockaddr * ) &address, sizeof( address ) ) < 0 )
+   {
+      if( fd >= 0 )
+      {
+         close( fd );
+      }
+      free( payload );
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   ok = sendFull( fd, payload, sizeof( request ) + size ) && readFull( fd, &response, sizeof( response ) ) && response.magic == SERVER_PROTOCOL_MAGIC;
+   ok = ok && copyOut( fd, response.outputLength, output != NULL ? output : stdout ) && copyOut( fd, response.errorLength, error != NULL ? error : stderr );
+   close( fd );
+   free( payload );
+
+   if( !ok )
+   {
+      return CLI_ERROR_PARSE_FAILED;
+   }
+
+   *result = response.result;
+
+   return CLI_SUCCESS;
+}
+
+
+// '--connect SOCKET COMMAND...': runs the command on the server and returns its result, or reports why it could not
+int connectCommand( int argc, const char *const argv[] )
+{
+int result;
+
+   if( argc < 4 )
+   {
+      fprintf( stderr, "Error: Usage: %s --connect SOCKET COMMAND [ARGS...]\n", argv[ 0 ] );
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   // The server sees the remaining words as a fresh argv, program name first
+   if( clientRequest( argv[ 2 ], argc - 2, argv + 2, stdout, stderr, &result ) != CLI_SUCCESS )
+   {
+      fprintf( stderr, "Error: Cannot reach server at '%s'\n", argv[ 2 ] );
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   return result;
+}
+
+
+// The '--connect' option without a CLI instance, for the top of main(): when argv asks for it, the command runs on the
+// server, its result is stored in `*result` and true is returned, so a client never builds the tree; otherwise false,
+// and the program goes on to build and parse as usual
+bool runConnect( int argc, char *argv[], int *result )
+{
+   if( argc < 2 || argv == NULL || result == NULL || strcmp( argv[ 1 ], "--connect" ) != 0 )
+   {
+      return false;
+   }
+
+   *result = connectCommand( argc, ( const char *const * ) argv );
+   return true;
+}
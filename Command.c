@@ -2,29 +2,174 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "Command.h"
 #include "CommandContext.h"
 #include "Argument.h"
 #include "Flag.h"
+#include "NameIndex.h"
+#include "Allocator.h"
 #include "CLI.h"
+#include "Help.h"
+#include "Parser.h"
+
+
+// Rendered help text, built on first use and kept until the command changes
+typedef struct
+{
+   size_t length;
+   char text[];
+} HelpText;
+
+
+// Positions in a list of subcommands or flags, in name order, for prefix queries on a list not kept sorted; made on
+// the first query and dropped when the list changes
+typedef struct
+{
+   int count;
+   int positions[];
+} NameOrder;
 
 
 typedef struct
 {
    Command_t interface;
+   const Allocator_t *allocator;
    char *name;
    char *description;
    struct Command **subCommands;
+   NameIndex_t *subCommandIndex;
    Argument_t **arguments;
    Flag_t **flags;
+   NameIndex_t *flagIndex;
+   int *shortFlags;
    struct Command *parent;
    int ( *handler )( const CommandContext_t * );
+   _Atomic( HelpText * ) help;
+   _Atomic( NameOrder * ) subCommandOrder;
+   _Atomic( NameOrder * ) flagOrder;
+   // A lazy command runs its loader the first time its contents are asked for, and is complete once pending is clear
+   CLILoader_t loader;
+   const struct CLI *cli;
+   void *loaderData;
+   // Recursive, since the loader registers through functions that look into the command being loaded
+   pthread_mutex_t loadLock;
+   atomic_bool pending;
+   bool loading;
+   bool frozen;
+   bool sorted;
+   bool compact;
    int subCommandCount;
    int argumentCount;
    int flagCount;
+   int subCommandCapacity;
+   int argumentCapacity;
+   int flagCapacity;
 } Implementation;
 
 
+// Serialises help rendering, name orders and their invalidation, which change a tree that concurrent parses may be reading; printing an
+// already rendered text takes no lock. Loaders run under their own command's lock instead, so that a slow one holds up
+// only what lies below it. It is recursive because a loader registers through the same functions that take it.
+static pthread_mutex_t treeLock;
+static pthread_once_t treeLockOnce = PTHREAD_ONCE_INIT;
+
+
+static void initTreeLock( void )
+{
+pthread_mutexattr_t attributes;
+
+   pthread_mutexattr_init( &attributes );
+   pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+   pthread_mutex_init( &treeLock, &attributes );
+   pthread_mutexattr_destroy( &attributes );
+}
+
+
+static void lockTree( void )
+{
+   pthread_once( &treeLockOnce, initTreeLock );
+   pthread_mutex_lock( &treeLock );
+}
+
+
+static void unlockTree( void )
+{
+   pthread_mutex_unlock( &treeLock );
+}
+
+
+static int freeze( Command_t *, bool );
+
+
+// The path a loader is given, as the CLI functions take it: names from below the root, separated by spaces
+static char * loaderPath( const Implementation *impl )
+{
+const Implementation *node;
+size_t length = 0, name;
+char *path;
+
+   for( node = impl; node-> parent != NULL; node = __containerof( node-> parent, Implementation, interface ) )
+   {
+      length += strlen( node-> name ) + 1;
+   }
+
+   if( ( path = malloc( length > 0 ? length : 1 ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   path[ length > 0 ? length - 1 : 0 ] = '\0';
+   for( node = impl; node-> parent != NULL; node = __containerof( node-> parent, Implementation, interface ) )
+   {
+      name = strlen( node-> name );
+      length -= name + 1;
+      memcpy( path + length, node-> name, name );
+      if( length > 0 )
+      {
+         path[ length - 1 ] = ' ';
+      }
+   }
+
+   return path;
+}
+
+
+// Runs a lazy command's loader before anything below it is read. Other threads reaching the command wait on its lock
+// until the subtree is complete, while the rest of the tree stays free; calls made by the loader itself, on the same
+// thread, pass through. A loader runs once: if it fails, what it registered stays and the failure is reported.
+static void load( Implementation *self )
+{
+char *path;
+
+   if( !atomic_load_explicit( &self-> pending, memory_order_acquire ) )
+   {
+      return;
+   }
+
+   pthread_mutex_lock( &self-> loadLock );
+   if( atomic_load_explicit( &self-> pending, memory_order_relaxed ) && !self-> loading )
+   {
+      self-> loading = true;
+      if( ( path = loaderPath( self ) ) == NULL || self-> loader( self-> cli, path, self-> loaderData ) != CLI_SUCCESS )
+      {
+         fprintf( stderr, "Error: Failed to load command '%s'.\n", path != NULL ? path : self-> name );
+      }
+      free( path );
+
+      // A command frozen before it was loaded is frozen again with what the loader added
+      if( self-> frozen )
+      {
+         freeze( &self-> interface, self-> compact );
+      }
+      self-> loading = false;
+      atomic_store_explicit( &self-> pending, false, memory_order_release );
+   }
+   pthread_mutex_unlock( &self-> loadLock );
+}
+
+
 static const char * getName( const Command_t *self )
 {
 Implementation *impl;
@@ -53,217 +198,283 @@ Implementation *impl;
 }
 
 
-static int findArgumentByName( Argument_t **arguments, int count, const char *name )
+// Renders the help text once and copies it into a HelpText from the tree's allocator
+static HelpText * renderHelp( const Command_t *self )
 {
-   for( int i = 0; i < count; i++ )
+Implementation *impl = __containerof( self, Implementation, interface );
+HelpText *help;
+char *text;
+size_t length;
+
+   if( ( text = formatHelp( self, &length ) ) == NULL )
    {
-      if( arguments[ i ] && arguments[ i ]-> getName( arguments[ i ] ) && strcmp( arguments[ i ]-> getName( arguments[ i ] ), name ) == 0 )
-      {
-         return i;
-      }
+      return NULL;
    }
 
-   return -1;
+   if( ( help = impl-> allocator-> allocate( impl-> allocator, sizeof( HelpText ) + length ) ) != NULL )
+   {
+      help-> length = length;
+      memcpy( help-> text, text, length );
+   }
+   free( text );
+
+   return help;
 }
 
 
-static Argument_t * getCommandArgument( const Command_t *self, const char *name )
+// Drops the cached help of one command; the check up front keeps tree construction off the lock
+static void dropHelp( Implementation *impl )
 {
-Argument_t **arguments;
-int count;
-int i;
+HelpText *help;
 
-   if( self == NULL )
+   if( atomic_load_explicit( &impl-> help, memory_order_acquire ) == NULL )
    {
-      return NULL;
+      return;
    }
 
-   arguments = self-> getArguments( self );
-   count = self-> getArgumentCount( self );
-
-   if( arguments != NULL && ( i = findArgumentByName( arguments, count, name ) ) >= 0 )
+   lockTree();
+   if( ( help = atomic_exchange( &impl-> help, NULL ) ) != NULL )
    {
-      return arguments[ i ];
+      impl-> allocator-> release( impl-> allocator, help, sizeof( HelpText ) + help-> length );
    }
-
-   return NULL;
+   unlockTree();
 }
 
 
-static const char * getArgumentValue( const Command_t *cmd, const char *name )
+// Attaching a subtree changes the path printed by every command in it
+static void dropSubtreeHelp( Implementation *impl )
 {
-Argument_t *arg = getCommandArgument( cmd, name );
-
-   if( arg != NULL )
+   dropHelp( impl );
+   for( int i = 0; i < impl-> subCommandCount; i++ )
    {
-      return arg-> getValue( arg );
+      dropSubtreeHelp( __containerof( impl-> subCommands[ i ], Implementation, interface ) );
    }
-
-   return NULL;
 }
 
 
-static char * buildCommandPath( const Command_t *self )
+static void printHelp( const Command_t *self, FILE *stream )
 {
-Implementation *impl = __containerof( self, Implementation, interface );
-size_t len;
-char *buf;
-char *parentPath;
+Implementation *impl;
+HelpText *help;
 
-   if( impl-> parent == NULL )
+   if( self == NULL || stream == NULL )
    {
-   char *result;
-
-      if( ( result = strdup( impl-> name ) ) == NULL )
-      {
-         return NULL;
-      }
-
-      return result;
+      return;
    }
-   else
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   if( ( help = atomic_load_explicit( &impl-> help, memory_order_acquire ) ) == NULL )
    {
-      if( ( parentPath = buildCommandPath( impl-> parent ) ) == NULL )
+      lockTree();
+      if( ( help = atomic_load_explicit( &impl-> help, memory_order_relaxed ) ) == NULL && ( help = renderHelp( self ) ) != NULL )
       {
-         return NULL;
+         atomic_store_explicit( &impl-> help, help, memory_order_release );
       }
+      unlockTree();
 
-      len = strlen( parentPath ) + strlen( impl-> name ) + 2;
-      if( ( buf = calloc( 1, len ) ) == NULL )
+      if( help == NULL )
       {
-         free( parentPath );
-         return NULL;
+         return;
       }
-
-      snprintf( buf, len, "%s %s", parentPath, impl-> name );
-      free( parentPath );
-
-      return buf;
    }
+
+   writeHelp( stream, help-> text, help-> length );
 }
 
 
-static void printHelp( const Command_t *self )
+// Grows a pointer array geometrically so that N insertions cost O(log N) reallocations
+static void * growArray( const Allocator_t *allocator, void *array, int *capacity, int required, size_t elementSize )
 {
-Implementation *impl = __containerof( self, Implementation, interface );
-char *fullPath = buildCommandPath( self );
-Argument_t **args;
-Flag_t **flags;
-int i, argCount, flagCount;
+int newCapacity;
+void *tmp;
 
-   if( self == NULL )
+   if( required <= *capacity )
    {
-      free( fullPath );
-      return;
+      return array;
    }
 
-   if( impl-> description != NULL )
+   newCapacity = *capacity > 0 ? *capacity * 2 : 4;
+   if( newCapacity < required )
    {
-      fprintf( stderr, "%s\n\n", impl-> description );
+      newCapacity = required;
    }
 
-   fprintf( stderr, "Usage: %s", fullPath );
+   if( ( tmp = allocator-> reallocate( allocator, array, elementSize * ( size_t ) *capacity, elementSize * ( size_t ) newCapacity ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   *capacity = newCapacity;
+
+   return tmp;
+}
+
+
+static const char * subCommandName( const Implementation *impl, int position )
+{
+   return __containerof( impl-> subCommands[ position ], Implementation, interface )-> name;
+}
+
+
+static const char * flagName( const Implementation *impl, int position )
+{
+   return impl-> flags[ position ]-> getName( impl-> flags[ position ] );
+}
 
-   args = self-> getArguments( self );
-   argCount = self-> getArgumentCount( self );
 
-   // Positional arguments
-   for( i = 0; i < argCount; i++ )
+// Stable merge sort of positions by the names they stand for
+static void sortPositions( const Implementation *impl, const char *( *nameAt )( const Implementation *, int ), int *positions, int *scratch, int count )
+{
+int middle = count / 2, left = 0, right = middle, out = 0;
+
+   if( count < 2 )
    {
-      if( args[ i ]-> isRequired( args[ i ] ) )
+      return;
+   }
+
+   sortPositions( impl, nameAt, positions, scratch, middle );
+   sortPositions( impl, nameAt, positions + middle, scratch, count - middle );
+
+   while( left < middle && right < count )
+   {
+      if( strcmp( nameAt( impl, positions[ right ] ), nameAt( impl, positions[ left ] ) ) < 0 )
       {
-         fprintf( stderr, " <%s>", args[ i ]-> getName( args[ i ] ) );
+         scratch[ out++ ] = positions[ right++ ];
       }
       else
       {
-         fprintf( stderr, " [%s]", args[ i ]-> getName( args[ i ] ) );
+         scratch[ out++ ] = positions[ left++ ];
       }
    }
-
-   flags = self-> getFlags( self );
-   flagCount = self-> getFlagCount( self );
-
-   if( flagCount > 0 )
+   while( left < middle )
    {
-      fprintf( stderr, " [OPTIONS]" );
+      scratch[ out++ ] = positions[ left++ ];
    }
+   memcpy( positions, scratch, sizeof( int ) * ( size_t ) right );
+}
 
-   if( impl-> subCommandCount > 0 )
-   {
-      fprintf( stderr, " COMMAND" );
-   }
 
-   fputs( "\n\n", stderr );
+// The name order of a list, made once under the tree lock; NULL when memory runs out, and the caller then scans
+static NameOrder * orderByName( Implementation *impl, _Atomic( NameOrder * ) *order, int count, const char *( *nameAt )( const Implementation *, int ) )
+{
+NameOrder *byName;
+int *scratch;
 
-   // Subcommands section
-   if( impl-> subCommandCount > 0 )
+   if( ( byName = atomic_load_explicit( order, memory_order_acquire ) ) != NULL )
    {
-      fputs( "Commands:\n", stderr );
+      return byName;
+   }
 
-      // Sort
-      for( int pass = 0; pass < impl-> subCommandCount - 1; pass++ )
+   lockTree();
+   if( ( byName = atomic_load_explicit( order, memory_order_relaxed ) ) == NULL && ( scratch = malloc( sizeof( int ) * ( size_t ) count ) ) != NULL )
+   {
+      if( ( byName = impl-> allocator-> allocate( impl-> allocator, sizeof( NameOrder ) + sizeof( int ) * ( size_t ) count ) ) != NULL )
       {
-         for( i = 0; i < impl-> subCommandCount - 1; i++ )
+         byName-> count = count;
+         for( int i = 0; i < count; i++ )
          {
-         Command_t *a = impl-> subCommands[ i ];
-         Command_t *b = impl-> subCommands[ i + 1 ];
-
-            if( strcmp( a-> getName( a ), b-> getName( b ) ) > 0 )
-            {
-            Command_t *tmp = impl-> subCommands[ i ];
-
-               impl-> subCommands[ i ] = b;
-               impl-> subCommands[ i + 1 ] = tmp;
-            }
+            byName-> positions[ i ] = i;
          }
+         sortPositions( impl, nameAt, byName-> positions, scratch, count );
+         atomic_store_explicit( order, byName, memory_order_release );
       }
+      free( scratch );
+   }
+   unlockTree();
 
-      for( i = 0; i < impl-> subCommandCount; i++ )
-      {
-      Command_t *sub = impl-> subCommands[ i ];
-      const char *desc = sub-> getDescription( sub );
+   return byName;
+}
 
-         fprintf( stderr, "   %-12s %s\n", sub-> getName( sub ), desc != NULL ? desc : "" );
-      }
-      fprintf( stderr, "\nRun '%s COMMAND --help' for more information on a command.\n\n", fullPath );
+
+// As dropHelp, for a name order
+static void dropOrder( Implementation *impl, _Atomic( NameOrder * ) *order )
+{
+NameOrder *byName;
+
+   if( atomic_load_explicit( order, memory_order_acquire ) == NULL )
+   {
+      return;
    }
 
-   // Flags section
-   if( flagCount > 0 )
+   lockTree();
+   if( ( byName = atomic_exchange( order, NULL ) ) != NULL )
    {
-      fputs( "Options:\n", stderr );
-      for( i = 0; i < flagCount; i++ )
-      {
-      Flag_t *f = flags[ i ];
-      char shortBuf[ 8 ] = { 0 };
+      impl-> allocator-> release( impl-> allocator, byName, sizeof( NameOrder ) + sizeof( int ) * ( size_t ) byName-> count );
+   }
+   unlockTree();
+}
 
-         if( f-> getShortName( f ) )
-         {
-            snprintf( shortBuf, sizeof( shortBuf ), "-%c, ", f-> getShortName( f ) );
-         }
 
-         fprintf( stderr, "   %s--%-18s %s\n", f-> getShortName( f ) ? shortBuf : "    ", f-> getName( f ), f-> getDescription( f ) ? f-> getDescription( f ) : "" );
+// Where a list's names starting with the prefix begin, taking the list in the given order or, without one, as it is;
+// the matches are the run from there on
+static int findPrefix( const Implementation *impl, const NameOrder *order, int count, const char *( *nameAt )( const Implementation *, int ), const char *prefix, size_t length )
+{
+int low = 0, high = count, middle;
+
+   while( low < high )
+   {
+      middle = low + ( high - low ) / 2;
+      if( strncmp( nameAt( impl, order != NULL ? order-> positions[ middle ] : middle ), prefix, length ) < 0 )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
       }
    }
 
-   free( fullPath );
+   return low;
 }
 
 
 static int addSubCommand( Command_t *self, Command_t *subCommand )
 {
 Implementation *impl = __containerof( self, Implementation, interface );
+Implementation *child = __containerof( subCommand, Implementation, interface );
 Command_t **tmp;
+int result;
 
-   if( ( tmp = realloc( impl-> subCommands, sizeof( Command_t * ) * ( size_t ) ( impl-> subCommandCount + 1 ) ) ) == NULL )
+   if( ( tmp = growArray( impl-> allocator, impl-> subCommands, &impl-> subCommandCapacity, impl-> subCommandCount + 1, sizeof( Command_t * ) ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
 
-   ( ( Implementation * )( subCommand ) )-> parent = self;
    impl-> subCommands = tmp;
+
+   // Compact commands keep no hash index; lookups binary-search the children once they are in order
+   if( !impl-> compact )
+   {
+      if( impl-> subCommandIndex == NULL && ( impl-> subCommandIndex = newNameIndex( impl-> allocator ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+
+      // A duplicate name stays reachable through the index as the first one registered
+      result = impl-> subCommandIndex-> insert( impl-> subCommandIndex, subCommand-> getName( subCommand ), impl-> subCommandCount );
+      if( result != CLI_SUCCESS && result != CLI_ERROR_ALREADY_EXISTS )
+      {
+         return result;
+      }
+   }
+
+   if( impl-> subCommandCount > 0 && strcmp( impl-> subCommands[ impl-> subCommandCount - 1 ]-> getName( impl-> subCommands[ impl-> subCommandCount - 1 ] ), child-> name ) > 0 )
+   {
+      impl-> sorted = false;
+   }
+
+   if( impl-> compact && child-> subCommandCount == 0 )
+   {
+      child-> compact = true;
+   }
+
+   child-> parent = self;
    impl-> subCommands[ impl-> subCommandCount ] = subCommand;
    impl-> subCommandCount++;
+   dropHelp( impl );
+   dropOrder( impl, &impl-> subCommandOrder );
+   dropSubtreeHelp( child );
 
    return CLI_SUCCESS;
 }
@@ -274,7 +485,7 @@ static int addArgument( const Command_t *self, Argument_t *argument )
 Implementation *impl = __containerof( self, Implementation, interface );
 Argument_t **tmp;
 
-   if( ( tmp = realloc( impl-> arguments, sizeof( Argument_t * ) * ( size_t ) ( impl-> argumentCount + 1 ) ) ) == NULL )
+   if( ( tmp = growArray( impl-> allocator, impl-> arguments, &impl-> argumentCapacity, impl-> argumentCount + 1, sizeof( Argument_t * ) ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
@@ -282,6 +493,7 @@ Argument_t **tmp;
    impl-> arguments = tmp;
    impl-> arguments[ impl-> argumentCount ] = argument;
    impl-> argumentCount++;
+   dropHelp( impl );
 
    return CLI_SUCCESS;
 }
@@ -291,20 +503,188 @@ static int addFlag( const Command_t *self, Flag_t *flag )
 {
 Implementation *impl = __containerof( self, Implementation, interface );
 Flag_t **tmp;
+unsigned char shortName = ( unsigned char ) flag-> getShortName( flag );
+int result;
 
-   if( ( tmp = realloc( impl-> flags, sizeof( Flag_t * ) * ( size_t ) ( impl-> flagCount + 1 ) ) ) == NULL )
+   if( ( tmp = growArray( impl-> allocator, impl-> flags, &impl-> flagCapacity, impl-> flagCount + 1, sizeof( Flag_t * ) ) ) == NULL )
    {
       return CLI_ERROR_MEMORY;
    }
 
    impl-> flags = tmp;
+
+   if( impl-> flagIndex == NULL && ( impl-> flagIndex = newNameIndex( impl-> allocator ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   // Short names are dispatched through a 256-entry table of flag positions, allocated only once a command has one
+   if( shortName != '\0' && impl-> shortFlags == NULL )
+   {
+      if( ( impl-> shortFlags = impl-> allocator-> allocate( impl-> allocator, 256 * sizeof( int ) ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      for( int i = 0; i < 256; i++ )
+      {
+         impl-> shortFlags[ i ] = -1;
+      }
+   }
+
+   // As with the previous linear scan, the first flag registered under a name wins
+   result = impl-> flagIndex-> insert( impl-> flagIndex, flag-> getName( flag ), impl-> flagCount );
+   if( result != CLI_SUCCESS && result != CLI_ERROR_ALREADY_EXISTS )
+   {
+      return result;
+   }
+
+   if( shortName != '\0' && impl-> shortFlags[ shortName ] < 0 )
+   {
+      impl-> shortFlags[ shortName ] = impl-> flagCount;
+   }
+
    impl-> flags[ impl-> flagCount ] = flag;
    impl-> flagCount++;
+   dropHelp( impl );
+   dropOrder( impl, &impl-> flagOrder );
 
    return CLI_SUCCESS;
 }
 
 
+static int reserve( const Command_t *self, int subCommands, int arguments, int flags )
+{
+Implementation *impl;
+void *tmp;
+
+   if( self == NULL || subCommands < 0 || arguments < 0 || flags < 0 )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+
+   if( ( tmp = growArray( impl-> allocator, impl-> subCommands, &impl-> subCommandCapacity, impl-> subCommandCount + subCommands, sizeof( Command_t * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+   impl-> subCommands = tmp;
+
+   if( ( tmp = growArray( impl-> allocator, impl-> arguments, &impl-> argumentCapacity, impl-> argumentCount + arguments, sizeof( Argument_t * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+   impl-> arguments = tmp;
+
+   if( ( tmp = growArray( impl-> allocator, impl-> flags, &impl-> flagCapacity, impl-> flagCount + flags, sizeof( Flag_t * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+   impl-> flags = tmp;
+
+   if( subCommands > 0 && !impl-> compact )
+   {
+      if( impl-> subCommandIndex == NULL && ( impl-> subCommandIndex = newNameIndex( impl-> allocator ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      if( impl-> subCommandIndex-> reserve( impl-> subCommandIndex, impl-> subCommandCount + subCommands ) != CLI_SUCCESS )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+   }
+
+   if( flags > 0 )
+   {
+      if( impl-> flagIndex == NULL && ( impl-> flagIndex = newNameIndex( impl-> allocator ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      if( impl-> flagIndex-> reserve( impl-> flagIndex, impl-> flagCount + flags ) != CLI_SUCCESS )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+   }
+
+   return CLI_SUCCESS;
+}
+
+
+// Adds this command, everything it owns and its whole subtree to the report; pointer arrays count at capacity, the
+// unused part of it as slack
+static void measure( const Command_t *self, CLIMemoryReport_t *report )
+{
+Implementation *impl;
+HelpText *help;
+NameOrder *order;
+
+   if( self == NULL || report == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   addMemoryUsage( &report-> commands, sizeof( Implementation ) );
+   addStringUsage( report, impl-> name );
+   addStringUsage( report, impl-> description );
+
+   if( impl-> subCommands != NULL )
+   {
+      addMemoryUsage( &report-> arrays, sizeof( Command_t * ) * ( size_t ) impl-> subCommandCapacity );
+      report-> arraySlack += sizeof( Command_t * ) * ( size_t )( impl-> subCommandCapacity - impl-> subCommandCount );
+   }
+   if( impl-> arguments != NULL )
+   {
+      addMemoryUsage( &report-> arrays, sizeof( Argument_t * ) * ( size_t ) impl-> argumentCapacity );
+      report-> arraySlack += sizeof( Argument_t * ) * ( size_t )( impl-> argumentCapacity - impl-> argumentCount );
+   }
+   if( impl-> flags != NULL )
+   {
+      addMemoryUsage( &report-> arrays, sizeof( Flag_t * ) * ( size_t ) impl-> flagCapacity );
+      report-> arraySlack += sizeof( Flag_t * ) * ( size_t )( impl-> flagCapacity - impl-> flagCount );
+   }
+
+   if( impl-> subCommandIndex != NULL )
+   {
+      impl-> subCommandIndex-> measure( impl-> subCommandIndex, &report-> indexes );
+   }
+   if( impl-> flagIndex != NULL )
+   {
+      impl-> flagIndex-> measure( impl-> flagIndex, &report-> indexes );
+   }
+   if( impl-> shortFlags != NULL )
+   {
+      addMemoryUsage( &report-> indexes, 256 * sizeof( int ) );
+   }
+   if( ( order = atomic_load_explicit( &impl-> subCommandOrder, memory_order_acquire ) ) != NULL )
+   {
+      addMemoryUsage( &report-> indexes, sizeof( NameOrder ) + sizeof( int ) * ( size_t ) order-> count );
+   }
+   if( ( order = atomic_load_explicit( &impl-> flagOrder, memory_order_acquire ) ) != NULL )
+   {
+      addMemoryUsage( &report-> indexes, sizeof( NameOrder ) + sizeof( int ) * ( size_t ) order-> count );
+   }
+
+   if( ( help = atomic_load_explicit( &impl-> help, memory_order_acquire ) ) != NULL )
+   {
+      addMemoryUsage( &report-> help, sizeof( HelpText ) + help-> length );
+   }
+
+   for( int i = 0; i < impl-> argumentCount; i++ )
+   {
+      impl-> arguments[ i ]-> measure( impl-> arguments[ i ], report );
+   }
+   for( int i = 0; i < impl-> flagCount; i++ )
+   {
+      impl-> flags[ i ]-> measure( impl-> flags[ i ], report );
+   }
+   for( int i = 0; i < impl-> subCommandCount; i++ )
+   {
+      impl-> subCommands[ i ]-> measure( impl-> subCommands[ i ], report );
+   }
+}
+
+
 static void delete( Command_t **selfPtr )
 {
 Implementation *impl;
@@ -325,7 +705,12 @@ Command_t *self;
          {
             impl-> subCommands[ i ]-> delete( &impl-> subCommands[ i ] );
          }
-         free( impl-> subCommands );
+         impl-> allocator-> release( impl-> allocator, impl-> subCommands, sizeof( Command_t * ) * ( size_t ) impl-> subCommandCapacity );
+      }
+
+      if( impl-> subCommandIndex != NULL )
+      {
+         impl-> subCommandIndex-> delete( &impl-> subCommandIndex );
       }
 
       if( impl-> arguments != NULL )
@@ -334,7 +719,7 @@ Command_t *self;
          {
             impl-> arguments[ i ]-> delete( &impl-> arguments[ i ] );
          }
-         free( impl-> arguments );
+         impl-> allocator-> release( impl-> allocator, impl-> arguments, sizeof( Argument_t * ) * ( size_t ) impl-> argumentCapacity );
       }
 
       if( impl-> flags != NULL )
@@ -343,239 +728,309 @@ Command_t *self;
          {
             impl-> flags[ i ]-> delete( &impl-> flags[ i ] );
          }
-         free( impl-> flags );
+         impl-> allocator-> release( impl-> allocator, impl-> flags, sizeof( Flag_t * ) * ( size_t ) impl-> flagCapacity );
+      }
+
+      if( impl-> flagIndex != NULL )
+      {
+         impl-> flagIndex-> delete( &impl-> flagIndex );
+      }
+      impl-> allocator-> release( impl-> allocator, impl-> shortFlags, 256 * sizeof( int ) );
+
+      dropHelp( impl );
+      dropOrder( impl, &impl-> subCommandOrder );
+      dropOrder( impl, &impl-> flagOrder );
+      if( impl-> loader != NULL )
+      {
+         pthread_mutex_destroy( &impl-> loadLock );
       }
 
-      free( impl-> name );
-      free( impl-> description );
-      free( impl );
+      impl-> allocator-> releaseString( impl-> allocator, impl-> description );
+      impl-> allocator-> releaseString( impl-> allocator, impl-> name );
+      impl-> allocator-> release( impl-> allocator, impl, sizeof( Implementation ) );
    }
    *selfPtr = NULL;
 }
 
 
-static bool parseFlag( const Command_t *self, const char *flagStr )
+// Orders a child's NUL-terminated name against a token of `length` bytes
+static int compareToken( const Implementation *child, const char *name, size_t length )
+{
+int result;
+
+   if( ( result = strncmp( child-> name, name, length ) ) != 0 )
+   {
+      return result;
+   }
+
+   return child-> name[ length ] != '\0';
+}
+
+
+static Command_t * findSubCommand( const Command_t *self, const char *name, size_t length )
 {
 Implementation *impl;
-Flag_t *flag;
+int i, low, high, middle;
 
-   if( self == NULL || flagStr == NULL || flagStr[ 0 ] != '-' )
+   if( self == NULL || name == NULL )
    {
-      return false;
+      return NULL;
    }
 
    impl = __containerof( self, Implementation, interface );
-   if( impl-> flags == NULL )
+   load( impl );
+   if( impl-> subCommandIndex != NULL )
    {
-      return false;
+      return ( i = impl-> subCommandIndex-> find( impl-> subCommandIndex, name, length ) ) >= 0 ? impl-> subCommands[ i ] : NULL;
    }
 
-   // Long flag: --flag
-   if( flagStr[ 1 ] == '-' && flagStr[ 2 ] != '\0' )
+   if( !impl-> sorted )
    {
-      for( int i = 0; i < impl-> flagCount; i++ )
+      for( i = 0; i < impl-> subCommandCount; i++ )
       {
-         flag = impl-> flags[ i ];
-         if( flag != NULL )
+         if( compareToken( __containerof( impl-> subCommands[ i ], Implementation, interface ), name, length ) == 0 )
          {
-            if( flag-> getName( flag ) != NULL && strcmp( flag-> getName( flag ), flagStr + 2 ) == 0 )
-            {
-               if( flag-> set != NULL )
-               {
-                  flag-> set( flag );
-               }
-               return true;
-            }
+            return impl-> subCommands[ i ];
          }
       }
+      return NULL;
    }
-   // Short flag: -f
-   else
+
+   // Lower bound, so that among duplicate names the first one registered wins, as with the index
+   low = 0;
+   high = impl-> subCommandCount;
+   while( low < high )
    {
-      for( int i = 0; i < impl-> flagCount; i++ )
+      middle = low + ( high - low ) / 2;
+      if( compareToken( __containerof( impl-> subCommands[ middle ], Implementation, interface ), name, length ) < 0 )
       {
-         flag = impl-> flags[ i ];
-         if( flag != NULL )
-         {
-            if( flag-> getShortName( flag ) == flagStr[ 1 ] )
-            {
-               if( flag-> set != NULL )
-               {
-                  flag-> set( flag );
-               }
-               return true;
-            }
-         }
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
       }
    }
 
-   return false;
+   if( low < impl-> subCommandCount && compareToken( __containerof( impl-> subCommands[ low ], Implementation, interface ), name, length ) == 0 )
+   {
+      return impl-> subCommands[ low ];
+   }
+
+   return NULL;
 }
 
 
-static Command_t *findSubCommand( Command_t *self, const char *name )
+// Stable merge sort by name, so duplicates keep their registration order
+static void sortByName( Command_t **items, Command_t **scratch, int count )
 {
-Implementation *impl = __containerof( self, Implementation, interface );
-int i;
+int middle = count / 2, left = 0, right = middle, out = 0;
 
-   for( i = 0; i < impl-> subCommandCount; i++ )
+   if( count < 2 )
    {
-   Command_t *sub = impl-> subCommands[ i ];
+      return;
+   }
 
-      if( strcmp( sub-> getName( sub ), name ) == 0 )
+   sortByName( items, scratch, middle );
+   sortByName( items + middle, scratch, count - middle );
+
+   while( left < middle && right < count )
+   {
+      if( strcmp( items[ right ]-> getName( items[ right ] ), items[ left ]-> getName( items[ left ] ) ) < 0 )
+      {
+         scratch[ out++ ] = items[ right++ ];
+      }
+      else
       {
-         return sub;
+         scratch[ out++ ] = items[ left++ ];
       }
    }
-   return NULL;
+   while( left < middle )
+   {
+      scratch[ out++ ] = items[ left++ ];
+   }
+   memcpy( items, scratch, sizeof( Command_t * ) * ( size_t ) right );
 }
 
 
-static int parse( Command_t *self, int argc, char *argv[] )
+// Sorts the children of this command and every command below it once, so that help needs no sorting and lookups can
+// binary-search. With `compact` the hash indexes are released and commands added later build none; otherwise they
+// are rebuilt for the new positions.
+static int freeze( Command_t *self, bool compact )
 {
-Command_t *current = self;
 Implementation *impl;
-Argument_t **arguments;
-int argCount;
-int i = 1;
-int pos = 0;
-int j;
+Command_t **scratch;
 int result;
 
-   if( argc == 1 )
-   {
-      self-> printHelp( self );
-      return CLI_SUCCESS;
-   }
-   if( self == NULL || argv == NULL || argc < 0 )
+   if( self == NULL )
    {
       return CLI_ERROR_INVALID_ARGUMENT;
    }
 
-   // Early help detection anywhere in the command chain
-   for( i = 1; i < argc; i++ )
+   impl = __containerof( self, Implementation, interface );
+   for( int i = 0; i < impl-> subCommandCount; i++ )
    {
-      if( strcmp( argv[ i ], "help" ) == 0 || strcmp( argv[ i ], "--help" ) == 0 || strcmp( argv[ i ], "-h" ) == 0 )
+      if( ( result = freeze( impl-> subCommands[ i ], compact ) ) != CLI_SUCCESS )
       {
-         current = self;
-         for( j = 1; j < i; j++ )
-         {
-         Command_t *sub;
-
-            if( ( sub = findSubCommand( current, argv[ j ] ) ) == NULL )
-            {
-               break;
-            }
-            current = sub;
-         }
-         current-> printHelp( current );
-         return CLI_SUCCESS;
+         return result;
       }
    }
 
-   // Resolve subcommand chain
-   i = 1;
-   while( i < argc && argv[ i ][ 0 ] != '-' )
+   if( !impl-> sorted )
    {
-   Command_t *sub;
-
-      if( ( sub = findSubCommand( current, argv[ i ] ) ) == NULL )
+      if( ( scratch = malloc( sizeof( Command_t * ) * ( size_t ) impl-> subCommandCount ) ) == NULL )
       {
-         break;
+         return CLI_ERROR_MEMORY;
+      }
+      sortByName( impl-> subCommands, scratch, impl-> subCommandCount );
+      free( scratch );
+      impl-> sorted = true;
+      dropHelp( impl );
+      dropOrder( impl, &impl-> subCommandOrder );
+
+      // Positions moved, so any index is stale
+      if( impl-> subCommandIndex != NULL )
+      {
+         impl-> subCommandIndex-> delete( &impl-> subCommandIndex );
       }
-      current = sub;
-      i++;
-   }
-
-   // Unknown root command?
-   if( current == self && argc > 1 && argv[ 1 ][ 0 ] != '-' && i == 1 )
-   {
-      fprintf( stderr, "Error: Unknown command '%s'\n", argv[ 1 ] );
-      self-> printHelp( self );
-      return CLI_ERROR_PARSE_FAILED;
    }
 
-   // Unknown subcommand in a group?
-   impl = ( Implementation * ) current;
-   if( i < argc && argv[ i ][ 0 ] != '-' && impl-> handler == NULL )
+   impl-> compact = compact;
+   impl-> frozen = true;
+   if( compact && impl-> subCommandIndex != NULL )
    {
-      fprintf( stderr, "Error: Unknown subcommand '%s'\n", argv[ i ] );
-      current-> printHelp( current );
-      return CLI_ERROR_PARSE_FAILED;
+      impl-> subCommandIndex-> delete( &impl-> subCommandIndex );
    }
 
-   arguments = current-> getArguments( current );
-   argCount  = current-> getArgumentCount( current );
-
-   // Parse flags + positional arguments
-   for( ; i < argc; i++ )
+   if( !compact && impl-> subCommandIndex == NULL && impl-> subCommandCount > 0 )
    {
-      if( argv[ i ][ 0 ] == '-' )
-      {
-         if( !parseFlag( current, argv[ i ] ) )
-         {
-            fprintf( stderr, "Error: Unknown flag '%s'\n", argv[ i ] );
-            current-> printHelp( current );
-            return CLI_ERROR_PARSE_FAILED;
-         }
-         continue;
-      }
-
-      if( pos < argCount )
+      if( ( impl-> subCommandIndex = newNameIndex( impl-> allocator ) ) == NULL || impl-> subCommandIndex-> reserve( impl-> subCommandIndex, impl-> subCommandCount ) != CLI_SUCCESS )
       {
-         arguments[ pos ]-> setValue( arguments[ pos ], argv[ i ] );
-         pos++;
+         return CLI_ERROR_MEMORY;
       }
-      else
+      for( int i = 0; i < impl-> subCommandCount; i++ )
       {
-         if( argCount == 0 )
-         {
-            fprintf( stderr, "Error: Unexpected argument '%s' (command takes no arguments)\n", argv[ i ] );
-         }
-         else
+         result = impl-> subCommandIndex-> insert( impl-> subCommandIndex, impl-> subCommands[ i ]-> getName( impl-> subCommands[ i ] ), i );
+         if( result != CLI_SUCCESS && result != CLI_ERROR_ALREADY_EXISTS )
          {
-            fputs( "Error: Too many arguments\n", stderr );
+            return result;
          }
-         current-> printHelp( current );
-         return CLI_ERROR_INVALID_ARGUMENT;
       }
    }
 
-   // Check required arguments
-   for( j = 0; j < argCount; j++ )
+   return CLI_SUCCESS;
+}
+
+
+static int execute( Command_t *self, int argc, const char *const argv[], FILE *output, FILE *error )
+{
+   return executeCommand( self, argc, argv, output, error );
+}
+
+
+static int parse( Command_t *self, int argc, const char *const argv[] )
+{
+   return execute( self, argc, argv, stdout, stderr );
+}
+
+
+static Command_t * getParent( const Command_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
    {
-   Argument_t *a = arguments[ j ];
+      return NULL;
+   }
 
-      if( a-> isRequired( a ) && a-> getValue( a ) == NULL )
-      {
-         fprintf( stderr, "Error: Required argument '%s' is missing\n", a-> getName( a ) );
-         current-> printHelp( current );
-         return CLI_ERROR_INVALID_ARGUMENT;
-      }
+   impl = __containerof( self, Implementation, interface );
+   return impl-> parent;
+}
+
+
+static int ( *getHandler( const Command_t *self ) )( const CommandContext_t * )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return NULL;
    }
 
-   // Execute handler if exists
-   if( impl-> handler != NULL )
+   impl = __containerof( self, Implementation, interface );
+   return impl-> handler;
+}
+
+
+static bool isSorted( const Command_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
    {
-   CommandContext_t *ctx;
+      return true;
+   }
 
-      if( ( ctx = newCommandContext( current, current-> getArguments( current ), current-> getArgumentCount( current ), current-> getFlags( current ), current-> getFlagCount( current ) ) ) == NULL )
-      {
-         fputs( "Error: Failed to create command context\n", stderr );
-         return CLI_ERROR_CONTEXT_FAILED;
-      }
-      result = impl-> handler( ctx );
-      ctx-> delete( &ctx );
-      if( result != CLI_SUCCESS && strcmp( current-> getName( current ), "help" ) != 0 )
+   impl = __containerof( self, Implementation, interface );
+   return impl-> sorted;
+}
+
+
+// Returns the position of the flag with this long name, or -1
+static int findFlag( const Command_t *self, const char *name, size_t length )
+{
+Implementation *impl;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   return impl-> flagIndex != NULL ? impl-> flagIndex-> find( impl-> flagIndex, name, length ) : -1;
+}
+
+
+// Returns the position of the argument with this name, or -1; arguments are few and looked up once, so they are scanned
+static int findArgument( const Command_t *self, const char *name, size_t length )
+{
+Implementation *impl;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   for( int i = 0; i < impl-> argumentCount; i++ )
+   {
+   const char *argumentName = impl-> arguments[ i ]-> getName( impl-> arguments[ i ] );
+
+      if( strncmp( argumentName, name, length ) == 0 && argumentName[ length ] == '\0' )
       {
-         fputs( "Error: Command execution failed\n", stderr );
-         current-> printHelp( current );
+         return i;
       }
-      return result;
    }
 
-   current-> printHelp( current );
-   return CLI_SUCCESS;
+   return -1;
+}
+
+
+// Returns the position of the flag with this short name, or -1
+static int findShortFlag( const Command_t *self, char shortName )
+{
+Implementation *impl;
+
+   if( self == NULL || shortName == '\0' )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   return impl-> shortFlags != NULL ? impl-> shortFlags[ ( unsigned char ) shortName ] : -1;
 }
 
 
@@ -589,6 +1044,7 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> subCommands;
 }
 
@@ -603,6 +1059,7 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> subCommandCount;
 }
 
@@ -617,6 +1074,7 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> arguments;
 }
 
@@ -631,6 +1089,7 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> argumentCount;
 }
 
@@ -645,6 +1104,7 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> flags;
 }
 
@@ -659,11 +1119,12 @@ Implementation *impl;
    }
 
    impl = __containerof( self, Implementation, interface );
+   load( impl );
    return impl-> flagCount;
 }
 
 
-static void forEachSubCommand( const Command_t *self, bool ( *cb )( Command_t * ) )
+static void forEachSubCommand( const Command_t *self, bool ( *cb )( Command_t *, void * ), void *userData )
 {
 int count;
 Command_t **subs;
@@ -677,7 +1138,94 @@ Command_t **subs;
    subs = self-> getSubCommands( self );
    for( int i = 0; i < count; i++ )
    {
-      if( !cb( subs[ i ] ) )
+      if( !cb( subs[ i ], userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// Visits the subcommands whose names start with the prefix, in name order. They are one run of the sorted level, or
+// of its name order when it was built out of order, found by binary search either way, so completion stays
+// logarithmic in the level's size whether or not the tree was frozen.
+static void forEachSubCommandWithPrefix( const Command_t *self, const char *prefix, size_t length, bool ( *cb )( Command_t *, void * ), void *userData )
+{
+Implementation *impl;
+NameOrder *order = NULL;
+int i;
+
+   if( self == NULL || prefix == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   if( impl-> subCommandCount == 0 )
+   {
+      return;
+   }
+
+   if( !impl-> sorted && ( order = orderByName( impl, &impl-> subCommandOrder, impl-> subCommandCount, subCommandName ) ) == NULL )
+   {
+      for( i = 0; i < impl-> subCommandCount; i++ )
+      {
+         if( strncmp( subCommandName( impl, i ), prefix, length ) == 0 && !cb( impl-> subCommands[ i ], userData ) )
+         {
+            break;
+         }
+      }
+      return;
+   }
+
+   for( int k = findPrefix( impl, order, impl-> subCommandCount, subCommandName, prefix, length ); k < impl-> subCommandCount; k++ )
+   {
+      i = order != NULL ? order-> positions[ k ] : k;
+      if( strncmp( subCommandName( impl, i ), prefix, length ) != 0 || !cb( impl-> subCommands[ i ], userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// As forEachSubCommandWithPrefix, for long flag names; flags are never sorted in place, so this always goes through
+// their name order
+static void forEachFlagWithPrefix( const Command_t *self, const char *prefix, size_t length, bool ( *cb )( Flag_t *, void * ), void *userData )
+{
+Implementation *impl;
+NameOrder *order;
+int i;
+
+   if( self == NULL || prefix == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   if( impl-> flagCount == 0 )
+   {
+      return;
+   }
+
+   if( ( order = orderByName( impl, &impl-> flagOrder, impl-> flagCount, flagName ) ) == NULL )
+   {
+      for( i = 0; i < impl-> flagCount; i++ )
+      {
+         if( strncmp( flagName( impl, i ), prefix, length ) == 0 && !cb( impl-> flags[ i ], userData ) )
+         {
+            break;
+         }
+      }
+      return;
+   }
+
+   for( int k = findPrefix( impl, order, impl-> flagCount, flagName, prefix, length ); k < impl-> flagCount; k++ )
+   {
+      i = order-> positions[ k ];
+      if( strncmp( flagName( impl, i ), prefix, length ) != 0 || !cb( impl-> flags[ i ], userData ) )
       {
          break;
       }
@@ -685,48 +1233,125 @@ Command_t **subs;
 }
 
 
-Command_t * newCommand( const char *name, const char *description, int ( *handler )( const CommandContext_t * ) )
+// The name of the subcommand at `position` in name order, for searches that walk a level in that order; NULL out of
+// range, or when no name order could be made
+static const char * getSubCommandNameInOrder( const Command_t *self, int position )
+{
+Implementation *impl;
+NameOrder *order;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   load( impl );
+   if( position < 0 || position >= impl-> subCommandCount )
+   {
+      return NULL;
+   }
+
+   if( impl-> sorted )
+   {
+      return subCommandName( impl, position );
+   }
+
+   return ( order = orderByName( impl, &impl-> subCommandOrder, impl-> subCommandCount, subCommandName ) ) != NULL ? subCommandName( impl, order-> positions[ position ] ) : NULL;
+}
+
+
+// Makes a command lazy: its subtree is left empty until parsing, help or completion first looks into it, and is then
+// registered by the loader through `cli`
+int setCommandLoader( Command_t *self, CLILoader_t loader, const struct CLI *cli, void *userData )
+{
+Implementation *impl;
+pthread_mutexattr_t attributes;
+
+   if( self == NULL || loader == NULL || cli == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   if( impl-> loader == NULL )
+   {
+      pthread_mutexattr_init( &attributes );
+      pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+      pthread_mutex_init( &impl-> loadLock, &attributes );
+      pthread_mutexattr_destroy( &attributes );
+   }
+   impl-> loader = loader;
+   impl-> cli = cli;
+   impl-> loaderData = userData;
+   atomic_store_explicit( &impl-> pending, true, memory_order_release );
+
+   return CLI_SUCCESS;
+}
+
+
+Command_t * newCommand( const Allocator_t *allocator, const char *name, const char *description, int ( *handler )( const CommandContext_t * ) )
 {
 Implementation *self;
 
-   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   if( allocator == NULL )
+   {
+      allocator = heapAllocator();
+   }
+
+   if( ( self = allocator-> allocate( allocator, sizeof( Implementation ) ) ) == NULL )
    {
       fputs( "Error: Failed to allocate memory for Command_t.\n", stderr );
       return NULL;
    }
 
-   if( ( self-> name = strdup( name ) ) == NULL )
+   self-> allocator = allocator;
+   if( ( self-> name = allocator-> duplicate( allocator, name ) ) == NULL )
    {
       fputs( "Error: Failed to allocate memory for command name.\n", stderr );
-      free( self );
+      allocator-> release( allocator, self, sizeof( Implementation ) );
       return NULL;
    }
 
-   if( description != NULL && ( self-> description = strdup( description ) ) == NULL )
+   if( description != NULL && ( self-> description = allocator-> duplicate( allocator, description ) ) == NULL )
    {
       fputs( "Error: Failed to allocate memory for command description.\n", stderr );
-      free( self-> name );
-      free( self );
+      allocator-> releaseString( allocator, self-> name );
+      allocator-> release( allocator, self, sizeof( Implementation ) );
       return NULL;
    }
 
    self-> handler = handler;
+   self-> sorted = true;
    self-> interface.addSubCommand = addSubCommand;
    self-> interface.addArgument = addArgument;
    self-> interface.addFlag = addFlag;
+   self-> interface.reserve = reserve;
    self-> interface.parse = parse;
+   self-> interface.execute = execute;
    self-> interface.delete = delete;
    self-> interface.getName = getName;
    self-> interface.getDescription = getDescription;
-   self-> interface.getArgumentValue = getArgumentValue;
    self-> interface.getArguments = getArguments;
    self-> interface.getArgumentCount = getArgumentCount;
    self-> interface.getFlags = getFlags;
    self-> interface.getFlagCount = getFlagCount;
    self-> interface.getSubCommands = getSubCommands;
    self-> interface.getSubCommandCount = getSubCommandCount;
+   self-> interface.getSubCommandNameInOrder = getSubCommandNameInOrder;
    self-> interface.printHelp = printHelp;
    self-> interface.forEachSubCommand = forEachSubCommand;
+   self-> interface.forEachSubCommandWithPrefix = forEachSubCommandWithPrefix;
+   self-> interface.forEachFlagWithPrefix = forEachFlagWithPrefix;
+   self-> interface.findSubCommand = findSubCommand;
+   self-> interface.freeze = freeze;
+   self-> interface.getParent = getParent;
+   self-> interface.getHandler = getHandler;
+   self-> interface.isSorted = isSorted;
+   self-> interface.findFlag = findFlag;
+   self-> interface.findShortFlag = findShortFlag;
+   self-> interface.findArgument = findArgument;
+   self-> interface.measure = measure;
 
    return &self-> interface;
 }
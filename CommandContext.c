@@ -1,23 +1,51 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include "CommandContext.h"
 #include "Command.h"
 #include "Argument.h"
 #include "Flag.h"
+#include "Allocator.h"
 
 
 typedef struct
 {
    CommandContext_t interface;
+   const Allocator_t *allocator;
    struct Command *command;
    Argument_t **arguments;
    Flag_t **flags;
+   FILE *output;
+   FILE *error;
+   const char **values;
    int argumentCount;
    int flagCount;
+   int flagWords;
+   uint64_t flagBits[];
 } Implementation;
 
 
+// Contexts that had to be allocated, process-wide; the ones built in the parser's stack storage cost no memory.
+// Argument values are never copied: the slots point into the parsed argv.
+static atomic_size_t heapContexts;
+static atomic_size_t heapContextBytes;
+
+
+// Flag states are one bit per handle, in the words right behind the context, with the argument slots after them
+static int wordsFor( int flagCount )
+{
+   return ( flagCount + 63 ) / 64;
+}
+
+
+static size_t contextSize( int argumentCount, int flagCount )
+{
+   return sizeof( Implementation ) + sizeof( uint64_t ) * ( size_t ) wordsFor( flagCount ) + sizeof( const char * ) * ( size_t ) argumentCount;
+}
+
+
 static const char * getArgument( const CommandContext_t *self, const char *name )
 {
 Implementation *impl;
@@ -32,7 +60,7 @@ Implementation *impl;
    {
       if( strcmp( impl-> arguments[ i ]-> getName( impl-> arguments[ i ] ), name ) == 0 )
       {
-         return impl-> arguments[ i ]-> getValue( impl-> arguments[ i ] );
+         return impl-> values[ i ];
       }
    }
 
@@ -54,7 +82,7 @@ Implementation *impl;
    {
       if( strcmp( impl-> flags[ i ]-> getName( impl-> flags[ i ] ), name ) == 0 )
       {
-         return impl-> flags[ i ]-> isSet( impl-> flags[ i ] );
+         return ( impl-> flagBits[ i / 64 ] >> ( i % 64 ) ) & 1;
       }
    }
 
@@ -62,44 +90,244 @@ Implementation *impl;
 }
 
 
-static void delete( CommandContext_t **selfPtr )
+// By handle: the argument's or flag's position in its command, from getArgumentId / getFlagId or findArgument / findFlag
+static const char * getArgumentById( const CommandContext_t *self, int id )
 {
 Implementation *impl;
 
-   if( selfPtr == NULL || *selfPtr == NULL )
+   if( self == NULL )
    {
-      return;
+      return NULL;
    }
 
-   impl = __containerof( *selfPtr, Implementation, interface );
+   impl = __containerof( self, Implementation, interface );
+   return id >= 0 && id < impl-> argumentCount ? impl-> values[ id ] : NULL;
+}
 
-   free( impl );
-   *selfPtr = NULL;
+
+static bool getFlagById( const CommandContext_t *self, int id )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return false;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   return id >= 0 && id < impl-> flagCount && ( ( impl-> flagBits[ id / 64 ] >> ( id % 64 ) ) & 1 );
 }
 
 
-CommandContext_t * newCommandContext( struct Command *cmd, Argument_t **arguments, int argumentCount, Flag_t **flags, int flagCount )
+// Word 0 holds the flags with handles 0 to 63, word 1 the next 64 and so on; words past the last flag read as 0
+static uint64_t getFlagBits( const CommandContext_t *self, int word )
 {
-Implementation *self;
+Implementation *impl;
 
-   if( cmd == NULL )
+   if( self == NULL )
    {
-      return NULL;
+      return 0;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   return word >= 0 && word < impl-> flagWords ? impl-> flagBits[ word ] : 0;
+}
+
+
+// The mask queries cover the first 64 handles, CLI_FLAG_BIT( id ) each
+static bool anyFlags( const CommandContext_t *self, uint64_t mask )
+{
+   return ( getFlagBits( self, 0 ) & mask ) != 0;
+}
+
+
+static bool allFlags( const CommandContext_t *self, uint64_t mask )
+{
+   return ( getFlagBits( self, 0 ) & mask ) == mask;
+}
+
+
+// Exactly the flags in the mask and no other, including any past the first 64
+static bool exactFlags( const CommandContext_t *self, uint64_t mask )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return mask == 0;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   for( int word = 1; word < impl-> flagWords; word++ )
+   {
+      if( impl-> flagBits[ word ] != 0 )
+      {
+         return false;
+      }
+   }
+
+   return getFlagBits( self, 0 ) == mask;
+}
+
+
+static FILE * getOutput( const CommandContext_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return stdout;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   return impl-> output;
+}
+
+
+static FILE * getErrorOutput( const CommandContext_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return stderr;
    }
 
-   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   impl = __containerof( self, Implementation, interface );
+   return impl-> error;
+}
+
+
+static struct Command * getCommand( const CommandContext_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
    {
       return NULL;
    }
 
+   impl = __containerof( self, Implementation, interface );
+   return impl-> command;
+}
+
+
+static void setArgument( CommandContext_t *self, int index, const char *value )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( index >= 0 && index < impl-> argumentCount )
+   {
+      impl-> values[ index ] = value;
+   }
+}
+
+
+static void setFlag( CommandContext_t *self, int index )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+
+   if( index >= 0 && index < impl-> flagCount )
+   {
+      impl-> flagBits[ index / 64 ] |= ( uint64_t ) 1 << ( index % 64 );
+   }
+}
+
+
+static void delete( CommandContext_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+
+   if( impl-> allocator != NULL )
+   {
+      impl-> allocator-> release( impl-> allocator, impl, contextSize( impl-> argumentCount, impl-> flagCount ) );
+   }
+   *selfPtr = NULL;
+}
+
+
+static CommandContext_t * setup( Implementation *self, const Allocator_t *allocator, struct Command *cmd, Argument_t **arguments, int argumentCount, Flag_t **flags, int flagCount, FILE *output, FILE *error )
+{
+   self-> allocator = allocator;
    self-> command = cmd;
    self-> arguments = arguments;
    self-> argumentCount = argumentCount;
    self-> flags = flags;
    self-> flagCount = flagCount;
+   self-> output = output != NULL ? output : stdout;
+   self-> error = error != NULL ? error : stderr;
+   self-> flagWords = wordsFor( flagCount );
+   self-> values = ( const char ** )( void * )( self-> flagBits + self-> flagWords );
    self-> interface.getArgument = getArgument;
    self-> interface.getFlag = getFlag;
+   self-> interface.getArgumentById = getArgumentById;
+   self-> interface.getFlagById = getFlagById;
+   self-> interface.getFlagBits = getFlagBits;
+   self-> interface.anyFlags = anyFlags;
+   self-> interface.allFlags = allFlags;
+   self-> interface.exactFlags = exactFlags;
+   self-> interface.getOutput = getOutput;
+   self-> interface.getErrorOutput = getErrorOutput;
+   self-> interface.getCommand = getCommand;
+   self-> interface.setArgument = setArgument;
+   self-> interface.setFlag = setFlag;
    self-> interface.delete = delete;
 
    return &self-> interface;
-} 
+}
+
+
+// The context is the per-parse result: argument slots and flag states live here, never in the shared command tree
+CommandContext_t * newCommandContext( const Allocator_t *allocator, struct Command *cmd, Argument_t **arguments, int argumentCount, Flag_t **flags, int flagCount, FILE *output, FILE *error )
+{
+Implementation *self;
+
+   if( cmd == NULL || argumentCount < 0 || flagCount < 0 )
+   {
+      return NULL;
+   }
+
+   if( allocator == NULL )
+   {
+      allocator = heapAllocator();
+   }
+
+   // Slots are carved out of the same block as the context, so a parse costs one allocation
+   if( ( self = allocator-> allocate( allocator, contextSize( argumentCount, flagCount ) ) ) == NULL )
+   {
+      return NULL;
+   }
+   atomic_fetch_add_explicit( &heapContexts, 1, memory_order_relaxed );
+   atomic_fetch_add_explicit( &heapContextBytes, contextSize( argumentCount, flagCount ), memory_order_relaxed );
+
+   return setup( self, allocator, cmd, arguments, argumentCount, flags, flagCount, output, error );
+}
+
+
+// Builds the context inside caller-provided storage, suitably aligned, instead of allocating it; returns NULL when
+// the storage is too small. Deleting such a context releases nothing.
+CommandContext_t * initCommandContext( void *storage, size_t size, struct Command *cmd, Argument_t **arguments, int argumentCount, Flag_t **flags, int flagCount, FILE *output, FILE *error )
+{
+   if( storage == NULL || cmd == NULL || argumentCount < 0 || flagCount < 0 || contextSize( argumentCount, flagCount ) > size )
+   {
+      return NULL;
+   }
+
+   memset( storage, 0, contextSize( argumentCount, flagCount ) );
+
+   return setup( storage, NULL, cmd, arguments, argumentCount, flags, flagCount, output, error );
+}
+
+
+void getContextUsage( CLIMemoryUsage_t *usage )
+{
+   usage-> allocations = atomic_load_explicit( &heapContexts, memory_order_relaxed );
+   usage-> bytes = atomic_load_explicit( &heapContextBytes, memory_order_relaxed );
+}
@@ -0,0 +1,97 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "Complete.h"
+#include "Command.h"
+#include "Flag.h"
+#include "CLI.h"
+
+
+static bool printName( Command_t *command, void *stream )
+{
+   fprintf( stream, "%s\n", command-> getName( command ) );
+   return true;
+}
+
+
+static bool printFlag( Flag_t *flag, void *stream )
+{
+   fprintf( stream, "--%s\n", flag-> getName( flag ) );
+   return true;
+}
+
+
+// Long flags starting with what follows "--", in name order; a bare "-" lists the short flags and then every long one
+static void completeFlags( const Command_t *command, const char *word, FILE *output )
+{
+Flag_t **flags = command-> getFlags( command );
+int count = command-> getFlagCount( command );
+const char *prefix = word[ 1 ] == '-' ? word + 2 : "";
+
+   if( word[ 1 ] == '\0' )
+   {
+      for( int i = 0; i < count; i++ )
+      {
+         if( flags[ i ]-> getShortName( flags[ i ] ) != '\0' )
+         {
+            fprintf( output, "-%c\n", flags[ i ]-> getShortName( flags[ i ] ) );
+         }
+      }
+   }
+   else if( word[ 1 ] != '-' )
+   {
+      return;
+   }
+
+   command-> forEachFlagWithPrefix( command, prefix, strlen( prefix ), printFlag, output );
+}
+
+
+// argv holds the words before the cursor and, last, the partial word under it. The words before it resolve the
+// command as parsing would, and the candidates for the partial word are written one per line: subcommands while the
+// line is still naming them, flags for a word starting with '-', nothing once "--" has ended the flags.
+int completeCommand( const Command_t *self, int argc, const char *const argv[], FILE *output )
+{
+const Command_t *current = self;
+const char *word;
+bool resolving = true;
+
+   if( self == NULL || argc < 0 || ( argc > 0 && argv == NULL ) || output == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( argc == 0 )
+   {
+      self-> forEachSubCommandWithPrefix( self, "", 0, printName, output );
+      return CLI_SUCCESS;
+   }
+
+   for( int i = 0; i < argc - 1; i++ )
+   {
+   Command_t *sub;
+
+      if( strcmp( argv[ i ], "--" ) == 0 )
+      {
+         return CLI_SUCCESS;
+      }
+      if( resolving && argv[ i ][ 0 ] != '-' && ( sub = current-> findSubCommand( current, argv[ i ], strlen( argv[ i ] ) ) ) != NULL )
+      {
+         current = sub;
+         continue;
+      }
+      resolving = false;
+   }
+
+   word = argv[ argc - 1 ];
+   if( word[ 0 ] == '-' )
+   {
+      completeFlags( current, word, output );
+   }
+   else if( resolving )
+   {
+      current-> forEachSubCommandWithPrefix( current, word, strlen( word ), printName, output );
+   }
+
+   return CLI_SUCCESS;
+}
@@ -2,15 +2,16 @@
 #include <string.h>
 #include <stdio.h>
 #include "Flag.h"
+#include "Allocator.h"
 
 
 typedef struct
 {
    Flag_t interface;
+   const Allocator_t *allocator;
    char *name;
    char *description;
    char shortName;
-   bool isSet;
 } Implementation;
 
 
@@ -56,25 +57,19 @@ Implementation *impl;
 }
 
 
-static bool isSet( const Flag_t *self )
+static void measure( const Flag_t *self, CLIMemoryReport_t *report )
 {
 Implementation *impl;
 
-   if( self == NULL )
+   if( self == NULL || report == NULL )
    {
-      return false;
+      return;
    }
 
    impl = __containerof( self, Implementation, interface );
-   return impl-> isSet;
-}
-
-
-static void set( const Flag_t *self )
-{
-Implementation *impl = __containerof( self, Implementation, interface );
-
-   impl-> isSet = true;
+   addMemoryUsage( &report-> flags, sizeof( Implementation ) );
+   addStringUsage( report, impl-> name );
+   addStringUsage( report, impl-> description );
 }
 
 
@@ -88,34 +83,40 @@ Implementation *impl;
    }
 
    impl = __containerof( *selfPtr, Implementation, interface );
-   free( impl-> name );
-   free( impl-> description );
-   free( impl );
+   impl-> allocator-> releaseString( impl-> allocator, impl-> description );
+   impl-> allocator-> releaseString( impl-> allocator, impl-> name );
+   impl-> allocator-> release( impl-> allocator, impl, sizeof( Implementation ) );
    *selfPtr = NULL;
 }
 
 
-Flag_t * newFlag( const char *name, char shortName, const char *description )
+Flag_t * newFlag( const Allocator_t *allocator, const char *name, char shortName, const char *description )
 {
 Implementation *self;
 
-   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   if( allocator == NULL )
+   {
+      allocator = heapAllocator();
+   }
+
+   if( ( self = allocator-> allocate( allocator, sizeof( Implementation ) ) ) == NULL )
    {
       return NULL;
    }
 
-   if( ( self-> name = strdup( name ) ) == NULL )
+   self-> allocator = allocator;
+   if( ( self-> name = allocator-> duplicate( allocator, name ) ) == NULL )
    {
-      free( self );
+      allocator-> release( allocator, self, sizeof( Implementation ) );
       return NULL;
    }
 
    if( description != NULL )
    {
-      if( ( self-> description = strdup( description ) ) == NULL )
+      if( ( self-> description = allocator-> duplicate( allocator, description ) ) == NULL )
       {
-         free( self-> name );
-         free( self );
+         allocator-> releaseString( allocator, self-> name );
+         allocator-> release( allocator, self, sizeof( Implementation ) );
          return NULL;
       }
    }
@@ -123,8 +124,7 @@ Implementation *self;
    self-> interface.getName = getName;
    self-> interface.getDescription = getDescription;
    self-> interface.getShortName = getShortName;
-   self-> interface.isSet = isSet;
-   self-> interface.set = set;
+   self-> interface.measure = measure;
    self-> interface.delete = delete;
 
    return &self-> interface;
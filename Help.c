@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include "Help.h"
+#include "Command.h"
+#include "Argument.h"
+#include "Flag.h"
+
+
+// Joins the names from the root down to self in one allocation, walking the parent chain instead of recursing
+char * buildCommandPath( const Command_t *self )
+{
+const Command_t *cmd;
+size_t length = 1, nameLength;
+char *path, *cursor;
+
+   for( cmd = self; cmd != NULL; cmd = cmd-> getParent( cmd ) )
+   {
+      length += strlen( cmd-> getName( cmd ) ) + ( cmd != self ? 1 : 0 );
+   }
+
+   if( ( path = malloc( length ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   cursor = path + length - 1;
+   *cursor = '\0';
+   for( cmd = self; cmd != NULL; cmd = cmd-> getParent( cmd ) )
+   {
+      nameLength = strlen( cmd-> getName( cmd ) );
+      cursor -= nameLength;
+      memcpy( cursor, cmd-> getName( cmd ), nameLength );
+      if( cursor > path )
+      {
+         *--cursor = ' ';
+      }
+   }
+
+   return path;
+}
+
+
+static int compareByName( const void *a, const void *b )
+{
+const Command_t *x = *( Command_t *const * ) a, *y = *( Command_t *const * ) b;
+
+   return strcmp( x-> getName( x ), y-> getName( y ) );
+}
+
+
+// Formats the complete help text of a command through its interface alone, so that every Command_t implementation
+// renders identically; returns a heap buffer of *length bytes, not NUL-terminated, or NULL
+char * formatHelp( const Command_t *self, size_t *length )
+{
+const char *description = self-> getDescription( self );
+char *fullPath, *buffer = NULL;
+size_t size = 0;
+FILE *stream;
+Command_t **listing, **copy = NULL;
+Argument_t **args;
+Flag_t **flags;
+int i, argCount, flagCount, subCommandCount = self-> getSubCommandCount( self );
+
+   if( ( fullPath = buildCommandPath( self ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   // Children registered or frozen in order are listed as they are; otherwise sort a copy, since the tree itself is
+   // shared by concurrent parses and must not be reordered here
+   // A snapshot's list is made on first use, and is missing if that fails or one of its commands is damaged
+   if( ( listing = self-> getSubCommands( self ) ) == NULL && subCommandCount > 0 )
+   {
+      free( fullPath );
+      return NULL;
+   }
+   if( subCommandCount > 0 && !self-> isSorted( self ) )
+   {
+      if( ( copy = malloc( sizeof( Command_t * ) * ( size_t ) subCommandCount ) ) == NULL )
+      {
+         free( fullPath );
+         return NULL;
+      }
+      memcpy( copy, listing, sizeof( Command_t * ) * ( size_t ) subCommandCount );
+      qsort( copy, ( size_t ) subCommandCount, sizeof( Command_t * ), compareByName );
+      listing = copy;
+   }
+
+   if( ( stream = open_memstream( &buffer, &size ) ) == NULL )
+   {
+      free( copy );
+      free( fullPath );
+      return NULL;
+   }
+
+   if( description != NULL )
+   {
+      fprintf( stream, "%s\n\n", description );
+   }
+
+   fprintf( stream, "Usage: %s", fullPath );
+
+   args = self-> getArguments( self );
+   argCount = self-> getArgumentCount( self );
+
+   // Positional arguments
+   for( i = 0; i < argCount; i++ )
+   {
+      if( args[ i ]-> isRequired( args[ i ] ) )
+      {
+         fprintf( stream, " <%s>", args[ i ]-> getName( args[ i ] ) );
+      }
+      else
+      {
+         fprintf( stream, " [%s]", args[ i ]-> getName( args[ i ] ) );
+      }
+   }
+
+   flags = self-> getFlags( self );
+   flagCount = self-> getFlagCount( self );
+
+   if( flagCount > 0 )
+   {
+      fprintf( stream, " [OPTIONS]" );
+   }
+
+   if( subCommandCount > 0 )
+   {
+      fprintf( stream, " COMMAND" );
+   }
+
+   fputs( "\n\n", stream );
+
+   // Subcommands section
+   if( subCommandCount > 0 )
+   {
+      fputs( "Commands:\n", stream );
+      for( i = 0; i < subCommandCount; i++ )
+      {
+      Command_t *sub = listing[ i ];
+      const char *desc = sub-> getDescription( sub );
+
+         fprintf( stream, "   %-12s %s\n", sub-> getName( sub ), desc != NULL ? desc : "" );
+      }
+      fprintf( stream, "\nRun '%s COMMAND --help' for more information on a command.\n\n", fullPath );
+   }
+
+   // Flags section
+   if( flagCount > 0 )
+   {
+      fputs( "Options:\n", stream );
+      for( i = 0; i < flagCount; i++ )
+      {
+      Flag_t *f = flags[ i ];
+      char shortBuf[ 8 ] = { 0 };
+
+         if( f-> getShortName( f ) )
+         {
+            snprintf( shortBuf, sizeof( shortBuf ), "-%c, ", f-> getShortName( f ) );
+         }
+
+         fprintf( stream, "   %s--%-18s %s\n", f-> getShortName( f ) ? shortBuf : "    ", f-> getName( f ), f-> getDescription( f ) ? f-> getDescription( f ) : "" );
+      }
+   }
+
+   free( copy );
+   free( fullPath );
+
+   if( fclose( stream ) != 0 )
+   {
+      free( buffer );
+      return NULL;
+   }
+
+   *length = size;
+
+   return buffer;
+}
+
+
+// A single write(2) when the stream has a descriptor, after flushing whatever the stream already buffered
+void writeHelp( FILE *stream, const char *text, size_t length )
+{
+ssize_t n;
+int fd;
+
+   fflush( stream );
+   if( ( fd = fileno( stream ) ) < 0 )
+   {
+      fwrite( text, 1, length, stream );
+      return;
+   }
+
+   while( length > 0 )
+   {
+      if( ( n = write( fd, text, length ) ) < 0 )
+      {
+         if( errno == EINTR )
+         {
+            continue;
+         }
+         return;
+      }
+      text += n;
+      length -= ( size_t ) n;
+   }
+}
@@ -0,0 +1,34 @@
+#include <string.h>
+#include "MemoryReport.h"
+
+
+void addMemoryUsage( CLIMemoryUsage_t *usage, size_t bytes )
+{
+   usage-> bytes += bytes;
+   usage-> allocations++;
+}
+
+
+// Names and descriptions are duplicated with their terminator; a missing description costs nothing
+void addStringUsage( CLIMemoryReport_t *report, const char *str )
+{
+   if( str != NULL )
+   {
+      addMemoryUsage( &report-> strings, strlen( str ) + 1 );
+   }
+}
+
+
+// Totals the tree categories; per-parse contexts are process-wide and kept apart
+void sumMemoryReport( CLIMemoryReport_t *report )
+{
+const CLIMemoryUsage_t *parts[] = { &report-> commands, &report-> arguments, &report-> flags, &report-> strings, &report-> arrays, &report-> indexes, &report-> help };
+
+   report-> total.bytes = 0;
+   report-> total.allocations = 0;
+   for( size_t i = 0; i < sizeof( parts ) / sizeof( parts[ 0 ] ); i++ )
+   {
+      report-> total.bytes += parts[ i ]-> bytes;
+      report-> total.allocations += parts[ i ]-> allocations;
+   }
+}
@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "NameIndex.h"
+#include "Allocator.h"
+#include "CLI.h"
+
+
+#define NAMEINDEX_INITIAL_CAPACITY   8
+
+
+typedef struct
+{
+   const char *key;
+   size_t length;
+   uint32_t hash;
+   int value;
+} Entry;
+
+
+typedef struct
+{
+   NameIndex_t interface;
+   const Allocator_t *allocator;
+   Entry *entries;
+   size_t capacity;
+   int count;
+} Implementation;
+
+
+// FNV-1a over exactly `length` bytes, so callers can look up tokens that are not NUL-terminated
+static uint32_t hashName( const char *name, size_t length )
+{
+uint32_t hash = 2166136261u;
+
+   for( size_t i = 0; i < length; i++ )
+   {
+      hash ^= ( unsigned char ) name[ i ];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+// Linear probing over a power-of-two table; returns the slot holding the key or the empty slot where it belongs
+static Entry * probe( Entry *entries, size_t capacity, const char *name, size_t length, uint32_t hash )
+{
+size_t mask = capacity - 1;
+size_t i = hash & mask;
+
+   while( entries[ i ].key != NULL )
+   {
+      if( entries[ i ].hash == hash && entries[ i ].length == length && memcmp( entries[ i ].key, name, length ) == 0 )
+      {
+         break;
+      }
+      i = ( i + 1 ) & mask;
+   }
+
+   return &entries[ i ];
+}
+
+
+static int grow( Implementation *impl, size_t capacity )
+{
+Entry *entries;
+
+   if( ( entries = impl-> allocator-> allocate( impl-> allocator, capacity * sizeof( Entry ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   for( size_t i = 0; i < impl-> capacity; i++ )
+   {
+      if( impl-> entries[ i ].key != NULL )
+      {
+         *probe( entries, capacity, impl-> entries[ i ].key, impl-> entries[ i ].length, impl-> entries[ i ].hash ) = impl-> entries[ i ];
+      }
+   }
+
+   impl-> allocator-> release( impl-> allocator, impl-> entries, impl-> capacity * sizeof( Entry ) );
+   impl-> entries = entries;
+   impl-> capacity = capacity;
+
+   return CLI_SUCCESS;
+}
+
+
+static int insert( const NameIndex_t *self, const char *name, int value )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+size_t length;
+uint32_t hash;
+Entry *entry;
+
+   if( name == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   // Keep the load factor at or below one half so probe sequences stay short
+   if( ( size_t )( impl-> count + 1 ) * 2 > impl-> capacity && grow( impl, impl-> capacity != 0 ? impl-> capacity * 2 : NAMEINDEX_INITIAL_CAPACITY ) != CLI_SUCCESS )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   length = strlen( name );
+   hash = hashName( name, length );
+   entry = probe( impl-> entries, impl-> capacity, name, length, hash );
+   if( entry-> key != NULL )
+   {
+      return CLI_ERROR_ALREADY_EXISTS;
+   }
+
+   entry-> key = name;
+   entry-> length = length;
+   entry-> hash = hash;
+   entry-> value = value;
+   impl-> count++;
+
+   return CLI_SUCCESS;
+}
+
+
+static int reserve( const NameIndex_t *self, int count )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+size_t capacity = impl-> capacity != 0 ? impl-> capacity : NAMEINDEX_INITIAL_CAPACITY;
+
+   if( count < 0 )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   while( ( size_t ) count * 2 > capacity )
+   {
+      capacity *= 2;
+   }
+
+   if( capacity == impl-> capacity )
+   {
+      return CLI_SUCCESS;
+   }
+
+   return grow( impl, capacity );
+}
+
+
+// Returns the value stored under the name, or -1 when it is not indexed
+static int find( const NameIndex_t *self, const char *name, size_t length )
+{
+Implementation *impl;
+Entry *entry;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   if( impl-> count == 0 )
+   {
+      return -1;
+   }
+
+   entry = probe( impl-> entries, impl-> capacity, name, length, hashName( name, length ) );
+
+   return entry-> key != NULL ? entry-> value : -1;
+}
+
+
+static int getCount( const NameIndex_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return 0;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   return impl-> count;
+}
+
+
+static void measure( const NameIndex_t *self, CLIMemoryUsage_t *usage )
+{
+Implementation *impl;
+
+   if( self == NULL || usage == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   addMemoryUsage( usage, sizeof( Implementation ) );
+   if( impl-> entries != NULL )
+   {
+      addMemoryUsage( usage, impl-> capacity * sizeof( Entry ) );
+   }
+}
+
+
+static void delete( NameIndex_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   impl-> allocator-> release( impl-> allocator, impl-> entries, impl-> capacity * sizeof( Entry ) );
+   impl-> allocator-> release( impl-> allocator, impl, sizeof( Implementation ) );
+   *selfPtr = NULL;
+}
+
+
+NameIndex_t * newNameIndex( const Allocator_t *allocator )
+{
+Implementation *self;
+
+   if( allocator == NULL )
+   {
+      allocator = heapAllocator();
+   }
+
+   if( ( self = allocator-> allocate( allocator, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   self-> allocator = allocator;
+   self-> interface.insert = insert;
+   self-> interface.reserve = reserve;
+   self-> interface.find = find;
+   self-> interface.getCount = getCount;
+   self-> interface.measure = measure;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
@@ -0,0 +1,277 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "ParallelBatch.h"
+#include "CLI.h"
+#include "Command.h"
+#include "Tokenizer.h"
+#include "ThreadPool.h"
+
+
+#define BATCH_READ_CHUNK          ( 64 * 1024 )
+// Lines read and run at a time per worker, which bounds the output held back for ordered replay
+#define BATCH_WINDOW_PER_WORKER   256
+
+
+typedef struct
+{
+   char *output;
+   char *error;
+   size_t outputLength;
+   size_t errorLength;
+   int result;
+   bool skipped;
+   bool done;
+} LineResult;
+
+
+typedef struct
+{
+   Command_t *root;
+   const CLIParallelOptions_t *options;
+   char **lines;
+   size_t *offsets;
+   char *buffer;
+   size_t bufferLength;
+   size_t bufferCapacity;
+   char *line;
+   size_t lineCapacity;
+   LineResult *results;
+   Tokenizer_t **tokenizers;
+   pthread_mutex_t lock;
+   size_t lineCount;
+   size_t nextToEmit;
+   // Lines of the stream before the current window, so that lines are reported by their place in the stream
+   unsigned long base;
+   unsigned long ran;
+   unsigned long failed;
+   int status;
+} Batch;
+
+
+// Reads the next window of at most `limit` records into the batch's buffer, each NUL-terminated in place of its
+// delimiter; the count is zero at the end of the stream
+static int readWindow( Batch *batch, FILE *stream, int delimiter, size_t limit )
+{
+ssize_t length;
+size_t needed;
+char *tmp;
+
+   batch-> lineCount = 0;
+   batch-> bufferLength = 0;
+   while( batch-> lineCount < limit && ( length = getdelim( &batch-> line, &batch-> lineCapacity, delimiter, stream ) ) > 0 )
+   {
+      if( batch-> line[ length - 1 ] == ( char ) delimiter )
+      {
+         length--;
+      }
+
+      needed = batch-> bufferLength + ( size_t ) length + 1;
+      if( needed > batch-> bufferCapacity )
+      {
+         needed = needed > batch-> bufferCapacity * 2 ? needed : batch-> bufferCapacity * 2;
+         needed = needed > BATCH_READ_CHUNK ? needed : BATCH_READ_CHUNK;
+         if( ( tmp = realloc( batch-> buffer, needed ) ) == NULL )
+         {
+            return CLI_ERROR_MEMORY;
+         }
+         batch-> buffer = tmp;
+         batch-> bufferCapacity = needed;
+      }
+
+      memcpy( batch-> buffer + batch-> bufferLength, batch-> line, ( size_t ) length );
+      batch-> buffer[ batch-> bufferLength + ( size_t ) length ] = '\0';
+      batch-> offsets[ batch-> lineCount++ ] = batch-> bufferLength;
+      batch-> bufferLength += ( size_t ) length + 1;
+   }
+
+   // The buffer may have moved while growing, so the lines are pointed into it only once it is complete
+   for( size_t i = 0; i < batch-> lineCount; i++ )
+   {
+      batch-> lines[ i ] = batch-> buffer + batch-> offsets[ i ];
+   }
+
+   return CLI_SUCCESS;
+}
+
+
+// Called with the batch lock held, in input order when the output is ordered and in completion order otherwise
+static void emit( Batch *batch, size_t index )
+{
+LineResult *r = &batch-> results[ index ];
+
+   if( r-> outputLength > 0 )
+   {
+      fwrite( r-> output, 1, r-> outputLength, stdout );
+   }
+   if( r-> errorLength > 0 )
+   {
+      fwrite( r-> error, 1, r-> errorLength, stderr );
+   }
+   free( r-> output );
+   free( r-> error );
+   r-> output = r-> error = NULL;
+
+   if( r-> skipped )
+   {
+      return;
+   }
+
+   batch-> ran++;
+   if( r-> result != CLI_SUCCESS )
+   {
+      batch-> failed++;
+      if( batch-> status == CLI_SUCCESS )
+      {
+         batch-> status = r-> result;
+      }
+   }
+   if( batch-> options-> onResult != NULL )
+   {
+      batch-> options-> onResult( batch-> options-> userData, batch-> base + ( unsigned long ) index + 1, r-> result );
+   }
+}
+
+
+static void runLine( void *userData, int worker, size_t index )
+{
+Batch *batch = userData;
+LineResult *r = &batch-> results[ index ];
+Tokenizer_t *tokenizer = batch-> tokenizers[ worker ];
+const char *const *argv;
+FILE *output, *error;
+int argc;
+
+   output = open_memstream( &r-> output, &r-> outputLength );
+   error = open_memstream( &r-> error, &r-> errorLength );
+
+   if( output == NULL || error == NULL )
+   {
+      r-> result = CLI_ERROR_MEMORY;
+   }
+   else if( ( argc = tokenizer-> tokenize( tokenizer, batch-> lines[ index ], &argv ) ) < 0 )
+   {
+      fprintf( error, "Error: Malformed batch line %lu\n", batch-> base + ( unsigned long ) index + 1 );
+      r-> result = argc;
+   }
+   else if( argc == 1 )
+   {
+      r-> skipped = true;
+   }
+   else
+   {
+      r-> result = batch-> root-> execute( batch-> root, argc, argv, output, error );
+   }
+
+   if( output != NULL )
+   {
+      fclose( output );
+   }
+   if( error != NULL )
+   {
+      fclose( error );
+   }
+
+   pthread_mutex_lock( &batch-> lock );
+   if( batch-> options-> ordered )
+   {
+      r-> done = true;
+      while( batch-> nextToEmit < batch-> lineCount && batch-> results[ batch-> nextToEmit ].done )
+      {
+         emit( batch, batch-> nextToEmit++ );
+      }
+   }
+   else
+   {
+      emit( batch, index );
+   }
+   pthread_mutex_unlock( &batch-> lock );
+}
+
+
+// Runs every command line of the stream on a work-stealing pool. Handlers run concurrently, each with its own
+// context whose output streams capture what it writes; captured output is replayed on stdout/stderr either in
+// input order or as lines complete. The stream is read and run a window at a time, so however long it is, at most
+// one window of lines and of their captured output is held.
+int runParallelBatch( Command_t *root, FILE *stream, int delimiter, const CLIParallelOptions_t *options, CLIBatchStats_t *stats )
+{
+Batch batch;
+ThreadPool_t *pool;
+struct timespec start, end;
+size_t window;
+int threads, result;
+
+   if( root == NULL || stream == NULL || options == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   threads = options-> threads > 0 ? options-> threads : 1;
+   window = ( size_t ) threads * BATCH_WINDOW_PER_WORKER;
+   memset( &batch, 0, sizeof( batch ) );
+   batch.root = root;
+   batch.options = options;
+   batch.status = CLI_SUCCESS;
+
+   clock_gettime( CLOCK_MONOTONIC, &start );
+   batch.lines = calloc( window, sizeof( char * ) );
+   batch.offsets = calloc( window, sizeof( size_t ) );
+   batch.results = calloc( window, sizeof( LineResult ) );
+   batch.tokenizers = calloc( ( size_t ) threads, sizeof( Tokenizer_t * ) );
+   pool = newThreadPool( threads );
+   result = batch.lines != NULL && batch.offsets != NULL && batch.results != NULL && batch.tokenizers != NULL && pool != NULL ? CLI_SUCCESS : CLI_ERROR_MEMORY;
+   for( int i = 0; result == CLI_SUCCESS && i < threads; i++ )
+   {
+      if( ( batch.tokenizers[ i ] = newTokenizer( root-> getName( root ) ) ) == NULL )
+      {
+         result = CLI_ERROR_MEMORY;
+      }
+   }
+
+   if( result == CLI_SUCCESS )
+   {
+      pthread_mutex_init( &batch.lock, NULL );
+      while( ( result = readWindow( &batch, stream, delimiter, window ) ) == CLI_SUCCESS && batch.lineCount > 0 )
+      {
+         memset( batch.results, 0, sizeof( LineResult ) * batch.lineCount );
+         batch.nextToEmit = 0;
+         if( ( result = pool-> run( pool, batch.lineCount, runLine, &batch ) ) != CLI_SUCCESS )
+         {
+            break;
+         }
+         batch.base += batch.lineCount;
+      }
+      pthread_mutex_destroy( &batch.lock );
+   }
+   clock_gettime( CLOCK_MONOTONIC, &end );
+
+   for( int i = 0; batch.tokenizers != NULL && i < threads; i++ )
+   {
+      if( batch.tokenizers[ i ] != NULL )
+      {
+         batch.tokenizers[ i ]-> delete( &batch.tokenizers[ i ] );
+      }
+   }
+   if( pool != NULL )
+   {
+      pool-> delete( &pool );
+   }
+   free( batch.tokenizers );
+   free( batch.results );
+   free( batch.offsets );
+   free( batch.lines );
+   free( batch.buffer );
+   free( batch.line );
+
+   if( stats != NULL )
+   {
+      stats-> lines = batch.ran;
+      stats-> failed = batch.failed;
+      stats-> seconds = ( double )( end.tv_sec - start.tv_sec ) + ( double )( end.tv_nsec - start.tv_nsec ) / 1e9;
+   }
+
+   return result != CLI_SUCCESS ? result : batch.status;
+}
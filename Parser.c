@@ -0,0 +1,391 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "Parser.h"
+#include "Command.h"
+#include "CommandContext.h"
+#include "Argument.h"
+#include "Allocator.h"
+#include "CLI.h"
+#include "Timing.h"
+#include "Complete.h"
+#include "Suggest.h"
+#include "Help.h"
+
+
+#define PARSER_CONTEXT_STORAGE   512
+
+
+// Where the single pass over argv is: naming subcommands, then flags and positionals, then after "--" positionals only
+typedef enum
+{
+   PARSE_COMMANDS,
+   PARSE_OPERANDS,
+   PARSE_POSITIONALS
+} ParseState;
+
+
+// What went wrong, kept so the message is printed from a literal format once the line is known to hold no help request
+typedef enum
+{
+   PARSE_UNKNOWN_COMMAND,
+   PARSE_UNKNOWN_SUBCOMMAND,
+   PARSE_CONTEXT_FAILED,
+   PARSE_UNKNOWN_FLAG,
+   PARSE_UNEXPECTED_ARGUMENT,
+   PARSE_TOO_MANY_ARGUMENTS,
+   PARSE_MISSING_ARGUMENT
+} ParseFailure;
+
+
+typedef struct
+{
+   ParseState state;
+   Command_t *command;
+   CommandContext_t *context;
+   int ( *handler )( const CommandContext_t * );
+   Argument_t **arguments;
+   int argumentCount;
+   int position;
+   // The first failure, reported only once the rest of the line holds no help request
+   int result;
+   ParseFailure failure;
+   const char *token;
+   TimingPhase_t phase;
+   bool help;
+   // The failure names a command or flag that does not exist, so close names are offered before falling back on help
+   bool suggest;
+} Parse;
+
+
+// Charges the time since the last lap to a phase when the dispatch is being timed
+static void lap( TimingSample_t *sample, TimingPhase_t phase )
+{
+   if( sample != NULL )
+   {
+      lapSample( sample, phase );
+   }
+}
+
+
+static void showHelp( TimingSample_t *sample, TimingPhase_t phase, const Command_t *command, FILE *error )
+{
+   lap( sample, phase );
+   command-> printHelp( command, error );
+   lap( sample, TIMING_HELP );
+}
+
+
+// Lists the names close to a mistyped one, which on a large level is both quicker to produce and more use than the
+// full help; returns false, printing nothing, if there are none
+static bool showSuggestions( TimingSample_t *sample, TimingPhase_t phase, const Command_t *command, const char *token, FILE *error )
+{
+const char *names[ SUGGEST_LIMIT ];
+char *path;
+int count;
+
+   lap( sample, phase );
+   if( ( count = findSuggestions( command, token, names, SUGGEST_LIMIT ) ) == 0 )
+   {
+      return false;
+   }
+
+   fputs( count == 1 ? "\nDid you mean this?\n" : "\nDid you mean one of these?\n", error );
+   for( int i = 0; i < count; i++ )
+   {
+      fprintf( error, "   %s%s\n", token[ 0 ] == '-' ? "--" : "", names[ i ] );
+   }
+   if( ( path = buildCommandPath( command ) ) != NULL )
+   {
+      fprintf( error, "\nRun '%s --help' for usage.\n", path );
+      free( path );
+   }
+   lap( sample, TIMING_HELP );
+
+   return true;
+}
+
+
+static bool isHelp( const char *token )
+{
+   return token[ 0 ] == 'h' ? strcmp( token, "help" ) == 0 : token[ 0 ] == '-' && ( strcmp( token, "-h" ) == 0 || strcmp( token, "--help" ) == 0 );
+}
+
+
+static void printFailure( const Parse *parse, FILE *error )
+{
+   switch( parse-> failure )
+   {
+      case PARSE_UNKNOWN_COMMAND:
+         fprintf( error, "Error: Unknown command '%s'\n", parse-> token );
+         break;
+      case PARSE_UNKNOWN_SUBCOMMAND:
+         fprintf( error, "Error: Unknown subcommand '%s'\n", parse-> token );
+         break;
+      case PARSE_CONTEXT_FAILED:
+         fputs( "Error: Failed to create command context\n", error );
+         break;
+      case PARSE_UNKNOWN_FLAG:
+         fprintf( error, "Error: Unknown flag '%s'\n", parse-> token );
+         break;
+      case PARSE_UNEXPECTED_ARGUMENT:
+         fprintf( error, "Error: Unexpected argument '%s' (command takes no arguments)\n", parse-> token );
+         break;
+      case PARSE_TOO_MANY_ARGUMENTS:
+         fputs( "Error: Too many arguments\n", error );
+         break;
+      case PARSE_MISSING_ARGUMENT:
+         fprintf( error, "Error: Required argument '%s' is missing\n", parse-> token );
+         break;
+   }
+}
+
+
+static void fail( Parse *parse, int result, ParseFailure failure, const char *token, TimingPhase_t phase, bool help, bool suggest )
+{
+   parse-> result = result;
+   parse-> failure = failure;
+   parse-> token = token;
+   parse-> phase = phase;
+   parse-> help = help;
+   parse-> suggest = suggest;
+}
+
+
+// Long flags by name; short ones by letter, several bundled behind one dash as in "-abc"
+static bool parseFlag( const Command_t *self, CommandContext_t *ctx, const char *flagStr )
+{
+int index;
+
+   if( flagStr[ 1 ] == '-' )
+   {
+      if( ( index = self-> findFlag( self, flagStr + 2, strlen( flagStr + 2 ) ) ) < 0 )
+      {
+         return false;
+      }
+      ctx-> setFlag( ctx, index );
+      return true;
+   }
+
+   if( flagStr[ 1 ] == '\0' )
+   {
+      return false;
+   }
+
+   for( const char *c = flagStr + 1; *c != '\0'; c++ )
+   {
+      if( ( index = self-> findShortFlag( self, *c ) ) < 0 )
+      {
+         return false;
+      }
+      ctx-> setFlag( ctx, index );
+   }
+
+   return true;
+}
+
+
+// Leaves the subcommand chain at the command it resolved to: token, when there is one, is the first that named no
+// subcommand. Parse results go to a per-parse context, so the tree is never written and can be shared between
+// parses; it lives in the caller's frame unless the command has too many arguments and flags for it, so most
+// dispatches allocate nothing.
+static void resolved( Parse *parse, const Command_t *root, const char *token, bool first, void *storage, size_t size, FILE *output, FILE *error, TimingSample_t *sample )
+{
+Command_t *current = parse-> command;
+
+   lap( sample, TIMING_RESOLVE );
+   if( sample != NULL )
+   {
+      sample-> command = current;
+   }
+
+   parse-> state = PARSE_OPERANDS;
+   parse-> handler = current-> getHandler( current );
+   if( token != NULL && token[ 0 ] != '-' && first && current == root )
+   {
+      fail( parse, CLI_ERROR_PARSE_FAILED, PARSE_UNKNOWN_COMMAND, token, TIMING_RESOLVE, true, true );
+      return;
+   }
+   if( token != NULL && token[ 0 ] != '-' && parse-> handler == NULL )
+   {
+      fail( parse, CLI_ERROR_PARSE_FAILED, PARSE_UNKNOWN_SUBCOMMAND, token, TIMING_RESOLVE, true, true );
+      return;
+   }
+
+   parse-> arguments = current-> getArguments( current );
+   parse-> argumentCount = current-> getArgumentCount( current );
+   if( ( parse-> context = initCommandContext( storage, size, current, parse-> arguments, parse-> argumentCount, current-> getFlags( current ), current-> getFlagCount( current ), output, error ) ) == NULL
+      && ( parse-> context = newCommandContext( heapAllocator(), current, parse-> arguments, parse-> argumentCount, current-> getFlags( current ), current-> getFlagCount( current ), output, error ) ) == NULL )
+   {
+      fail( parse, CLI_ERROR_CONTEXT_FAILED, PARSE_CONTEXT_FAILED, NULL, TIMING_CONTEXT, false, false );
+      return;
+   }
+   lap( sample, TIMING_CONTEXT );
+}
+
+
+static void operand( Parse *parse, const char *token )
+{
+   if( parse-> state == PARSE_OPERANDS && token[ 0 ] == '-' )
+   {
+      if( token[ 1 ] == '-' && token[ 2 ] == '\0' )
+      {
+         parse-> state = PARSE_POSITIONALS;
+      }
+      else if( !parseFlag( parse-> command, parse-> context, token ) )
+      {
+         fail( parse, CLI_ERROR_PARSE_FAILED, PARSE_UNKNOWN_FLAG, token, TIMING_ARGUMENTS, true, true );
+      }
+      return;
+   }
+
+   if( parse-> position < parse-> argumentCount )
+   {
+      parse-> context-> setArgument( parse-> context, parse-> position++, token );
+   }
+   else if( parse-> argumentCount == 0 )
+   {
+      fail( parse, CLI_ERROR_INVALID_ARGUMENT, PARSE_UNEXPECTED_ARGUMENT, token, TIMING_ARGUMENTS, true, false );
+   }
+   else
+   {
+      fail( parse, CLI_ERROR_INVALID_ARGUMENT, PARSE_TOO_MANY_ARGUMENTS, token, TIMING_ARGUMENTS, true, false );
+   }
+}
+
+
+// One left-to-right pass classifies every token once, so the work is linear in argc. A help request anywhere before
+// "--" wins over any error, so errors found on the way are held until the end of the line.
+static int dispatch( Command_t *self, int argc, const char *const argv[], FILE *output, FILE *error, TimingSample_t *sample )
+{
+_Alignas( max_align_t ) unsigned char storage[ PARSER_CONTEXT_STORAGE ];
+Parse parse = { PARSE_COMMANDS, self, NULL, NULL, NULL, 0, 0, CLI_SUCCESS, PARSE_UNKNOWN_COMMAND, NULL, TIMING_RESOLVE, false, false };
+int result;
+
+   if( argc == 1 )
+   {
+      showHelp( sample, TIMING_RESOLVE, self, error );
+      return CLI_SUCCESS;
+   }
+   if( self == NULL || argv == NULL || argc < 0 )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   for( int i = 1; i < argc; i++ )
+   {
+   const char *token = argv[ i ];
+   Command_t *sub;
+
+      if( parse.state != PARSE_POSITIONALS && isHelp( token ) )
+      {
+         if( parse.context != NULL )
+         {
+            parse.context-> delete( &parse.context );
+         }
+         if( sample != NULL )
+         {
+            sample-> command = parse.command;
+         }
+         showHelp( sample, TIMING_RESOLVE, parse.command, error );
+         return CLI_SUCCESS;
+      }
+      if( parse.result != CLI_SUCCESS )
+      {
+         continue;
+      }
+
+      if( parse.state == PARSE_COMMANDS )
+      {
+         if( token[ 0 ] != '-' && ( sub = parse.command-> findSubCommand( parse.command, token, strlen( token ) ) ) != NULL )
+         {
+            parse.command = sub;
+            continue;
+         }
+         resolved( &parse, self, token, i == 1, storage, sizeof( storage ), output, error, sample );
+         if( parse.result != CLI_SUCCESS )
+         {
+            continue;
+         }
+      }
+
+      operand( &parse, token );
+   }
+
+   if( parse.state == PARSE_COMMANDS )
+   {
+      resolved( &parse, self, NULL, false, storage, sizeof( storage ), output, error, sample );
+   }
+
+   // Positionals fill in order, so only the arguments past the last one given can be missing
+   for( int j = parse.position; parse.result == CLI_SUCCESS && j < parse.argumentCount; j++ )
+   {
+      if( parse.arguments[ j ]-> isRequired( parse.arguments[ j ] ) )
+      {
+         fail( &parse, CLI_ERROR_INVALID_ARGUMENT, PARSE_MISSING_ARGUMENT, parse.arguments[ j ]-> getName( parse.arguments[ j ] ), TIMING_ARGUMENTS, true, false );
+      }
+   }
+
+   if( parse.result != CLI_SUCCESS )
+   {
+      printFailure( &parse, error );
+      if( parse.help && !( parse.suggest && showSuggestions( sample, parse.phase, parse.command, parse.token, error ) ) )
+      {
+         showHelp( sample, parse.phase, parse.command, error );
+      }
+      if( parse.context != NULL )
+      {
+         parse.context-> delete( &parse.context );
+      }
+      return parse.result;
+   }
+   lap( sample, TIMING_ARGUMENTS );
+
+   // Execute handler if exists
+   if( parse.handler != NULL )
+   {
+      result = parse.handler( parse.context );
+      lap( sample, TIMING_HANDLER );
+      parse.context-> delete( &parse.context );
+      lap( sample, TIMING_CONTEXT );
+      if( result != CLI_SUCCESS && strcmp( parse.command-> getName( parse.command ), "help" ) != 0 )
+      {
+         fputs( "Error: Command execution failed\n", error );
+         showHelp( sample, TIMING_HANDLER, parse.command, error );
+      }
+      return result;
+   }
+
+   parse.context-> delete( &parse.context );
+   showHelp( sample, TIMING_CONTEXT, parse.command, error );
+   return CLI_SUCCESS;
+}
+
+
+// Parses and dispatches one command line, sending diagnostics and help to `error` and handing both streams to the
+// handler through its context, so that callers running many lines at once can capture each line's output separately.
+// With timing enabled, the phases of the dispatch are added to the histograms of the command it resolved to.
+int executeCommand( Command_t *self, int argc, const char *const argv[], FILE *output, FILE *error )
+{
+TimingSample_t sample;
+int result;
+
+   // Shells ask for candidates with the hidden first word; such a line is never dispatched or timed
+   if( self != NULL && argc >= 2 && argv != NULL && strcmp( argv[ 1 ], CLI_COMPLETE_COMMAND ) == 0 )
+   {
+      return completeCommand( self, argc - 2, argv + 2, output );
+   }
+
+   if( !isTimingEnabled() || self == NULL )
+   {
+      return dispatch( self, argc, argv, output, error, NULL );
+   }
+
+   startSample( &sample, self );
+   result = dispatch( self, argc, argv, output, error, &sample );
+   recordSample( &sample );
+
+   return result;
+}
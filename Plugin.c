@@ -0,0 +1,277 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <dlfcn.h>
+#include "Plugin.h"
+#include "CLI.h"
+#include "Tokenizer.h"
+
+
+typedef struct Library
+{
+   struct Library *next;
+   char *path;
+   char *entry;
+   void *handle;
+} Library;
+
+
+typedef struct
+{
+   Plugins_t interface;
+   Library *libraries;
+} Implementation;
+
+
+// The loader of every plugin command. It runs once, under its command's own lock, so the library is opened by exactly
+// one thread; the handle stays open for as long as the tree may call into it.
+static int openLibrary( const CLI_t *cli, const char *path, void *userData )
+{
+Library *library = userData;
+union
+{
+   void *symbol;
+   CLILoader_t function;
+} entry;
+
+   if( library-> handle == NULL )
+   {
+      if( ( library-> handle = dlopen( library-> path, RTLD_NOW | RTLD_LOCAL ) ) == NULL )
+      {
+         fprintf( stderr, "Error: %s\n", dlerror() );
+         return CLI_ERROR_NOT_FOUND;
+      }
+   }
+
+   if( ( entry.symbol = dlsym( library-> handle, library-> entry ) ) == NULL )
+   {
+      fprintf( stderr, "Error: %s\n", dlerror() );
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   return entry.function( cli, path, NULL );
+}
+
+
+// A library named without a '/' is looked for next to the manifest rather than along the loader's search path
+static char * libraryPath( const char *manifest, const char *name )
+{
+const char *slash = strrchr( manifest, '/' );
+size_t directory = slash != NULL ? ( size_t )( slash - manifest ) + 1 : 2;
+char *path;
+
+   if( name[ 0 ] == '/' )
+   {
+      return strdup( name );
+   }
+
+   if( ( path = malloc( directory + strlen( name ) + 1 ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   memcpy( path, slash != NULL ? manifest : "./", directory );
+   strcpy( path + directory, name );
+
+   return path;
+}
+
+
+// Registers the command at a manifest path: the levels are separated by '/', as in cligen descriptions, and turned into
+// the space-separated parent path the CLI functions take
+static int addEntry( const CLI_t *cli, const char *path, const char *description, Library *library )
+{
+char *parent, *name;
+int result;
+
+   if( ( parent = strdup( path ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   if( ( name = strrchr( parent, '/' ) ) != NULL )
+   {
+      *name++ = '\0';
+      for( char *c = parent; *c != '\0'; c++ )
+      {
+         *c = *c == '/' ? ' ' : *c;
+      }
+   }
+   else
+   {
+      name = parent;
+   }
+
+   if( *name == '\0' )
+   {
+      result = CLI_ERROR_INVALID_ARGUMENT;
+   }
+   else if( library != NULL )
+   {
+      result = cli-> addLazyCommand( cli, name != parent ? parent : NULL, name, description, NULL, openLibrary, library );
+   }
+   else if( name != parent )
+   {
+      result = cli-> addSubCommand( cli, parent, name, description, NULL );
+   }
+   else
+   {
+      result = cli-> addCommand( cli, name, description, NULL );
+   }
+
+   free( parent );
+
+   return result;
+}
+
+
+static Library * newLibrary( Implementation *impl, const char *manifest, const char *name, const char *entry )
+{
+Library *library;
+
+   if( ( library = calloc( 1, sizeof( Library ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   if( ( library-> path = libraryPath( manifest, name ) ) == NULL || ( library-> entry = strdup( entry ) ) == NULL )
+   {
+      free( library-> path );
+      free( library );
+      return NULL;
+   }
+
+   library-> next = impl-> libraries;
+   impl-> libraries = library;
+
+   return library;
+}
+
+
+// The manifest declares the shape of the tree, so nothing is opened to build it; one declaration per line:
+//
+//    command PATH DESCRIPTION                  a plain group, to hang plugins below
+//    plugin PATH LIBRARY DESCRIPTION [ENTRY]   a group whose subtree the library registers when first reached
+//
+// '#' starts a comment line and strings containing blanks are quoted. Lines before a malformed one stay registered.
+static int load( Plugins_t *self, const CLI_t *cli, const char *manifest )
+{
+Implementation *impl;
+Tokenizer_t *tokenizer;
+const char *const *argv;
+Library *library;
+char *line = NULL;
+size_t capacity = 0;
+int argc, lineNumber, result = CLI_SUCCESS;
+FILE *stream;
+
+   if( self == NULL || cli == NULL || manifest == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   if( ( stream = fopen( manifest, "r" ) ) == NULL )
+   {
+      return CLI_ERROR_NOT_FOUND;
+   }
+
+   if( ( tokenizer = newTokenizer( manifest ) ) == NULL )
+   {
+      fclose( stream );
+      return CLI_ERROR_MEMORY;
+   }
+
+   for( lineNumber = 1; result == CLI_SUCCESS && getline( &line, &capacity, stream ) > 0; lineNumber++ )
+   {
+      line[ strcspn( line, "\n" ) ] = '\0';
+      if( line[ strspn( line, " \t" ) ] == '#' )
+      {
+         continue;
+      }
+
+      if( ( argc = tokenizer-> tokenize( tokenizer, line, &argv ) ) < 0 )
+      {
+         result = argc;
+      }
+      else if( argc < 2 )
+      {
+         continue;
+      }
+      else if( strcmp( argv[ 1 ], "command" ) == 0 && argc == 4 )
+      {
+         result = addEntry( cli, argv[ 2 ], argv[ 3 ], NULL );
+      }
+      else if( strcmp( argv[ 1 ], "plugin" ) == 0 && ( argc == 5 || argc == 6 ) )
+      {
+         if( ( library = newLibrary( impl, manifest, argv[ 3 ], argc == 6 ? argv[ 5 ] : CLI_PLUGIN_ENTRY ) ) == NULL )
+         {
+            result = CLI_ERROR_MEMORY;
+         }
+         else
+         {
+            result = addEntry( cli, argv[ 2 ], argv[ 4 ], library );
+         }
+      }
+      else
+      {
+         result = CLI_ERROR_PARSE_FAILED;
+      }
+
+      if( result != CLI_SUCCESS )
+      {
+         fprintf( stderr, "Error: %s:%d: cannot declare '%s'\n", manifest, lineNumber, argc > 2 ? argv[ 2 ] : line );
+      }
+   }
+
+   free( line );
+   tokenizer-> delete( &tokenizer );
+   fclose( stream );
+
+   return result;
+}
+
+
+// Only to be called once the tree using the libraries is gone, as their handlers are then unreachable
+static void delete( Plugins_t **selfPtr )
+{
+Implementation *impl;
+Library *library;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   while( ( library = impl-> libraries ) != NULL )
+   {
+      impl-> libraries = library-> next;
+      if( library-> handle != NULL )
+      {
+         dlclose( library-> handle );
+      }
+      free( library-> entry );
+      free( library-> path );
+      free( library );
+   }
+   free( impl );
+   *selfPtr = NULL;
+}
+
+
+Plugins_t * newPlugins( void )
+{
+Implementation *self;
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   self-> interface.load = load;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
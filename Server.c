@@ -0,0 +1,293 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "Server.h"
+#include "Socket.h"
+#include "Command.h"
+#include "CLI.h"
+#include "Timing.h"
+
+
+typedef struct
+{
+   Command_t *root;
+   int listenFd;
+   int stopFd;
+} Server;
+
+
+// Waits until fd is readable; false once the server is stopping
+static bool waitReadable( const Server *server, int fd )
+{
+struct pollfd fds[ 2 ] = { { fd, POLLIN, 0 }, { server-> stopFd, POLLIN, 0 } };
+
+   for( ;; )
+   {
+      if( poll( fds, 2, -1 ) < 0 )
+      {
+         if( errno == EINTR )
+         {
+            continue;
+         }
+         return false;
+      }
+
+      return fds[ 1 ].revents == 0;
+   }
+}
+
+
+// Serves requests on one connection until the client hangs up, sends something malformed, or the server stops
+static void serveConnection( const Server *server, int fd )
+{
+ServerRequestHeader_t request;
+ServerResponseHeader_t response;
+char *buffer = NULL, *tmp, *output, *error;
+const char **argv = NULL, **argvTmp;
+size_t bufferCapacity = 0, argvCapacity = 0, outputLength, errorLength;
+FILE *outputStream, *errorStream;
+
+   while( waitReadable( server, fd ) && readFull( fd, &request, sizeof( request ) ) )
+   {
+   char *cursor, *end;
+   uint32_t argc = 0;
+
+      if( request.magic != SERVER_PROTOCOL_MAGIC || request.argc == 0 || request.argc > SERVER_MAX_ARGC || request.size > SERVER_MAX_REQUEST )
+      {
+         break;
+      }
+
+      if( request.size + 1 > bufferCapacity )
+      {
+         if( ( tmp = realloc( buffer, request.size + 1 ) ) == NULL )
+         {
+            break;
+         }
+         buffer = tmp;
+         bufferCapacity = request.size + 1;
+      }
+      if( request.argc + 1 > argvCapacity )
+      {
+         if( ( argvTmp = realloc( argv, sizeof( char * ) * ( request.argc + 1 ) ) ) == NULL )
+         {
+            break;
+         }
+         argv = argvTmp;
+         argvCapacity = request.argc + 1;
+      }
+
+      if( !readFull( fd, buffer, request.size ) )
+      {
+         break;
+      }
+      buffer[ request.size ] = '\0';
+
+      for( cursor = buffer, end = buffer + request.size; cursor < end && argc < request.argc; cursor += strlen( cursor ) + 1 )
+      {
+         argv[ argc++ ] = cursor;
+      }
+      if( argc != request.argc || cursor != end )
+      {
+         break;
+      }
+      argv[ argc ] = NULL;
+
+      output = error = NULL;
+      outputLength = errorLength = 0;
+      if( ( outputStream = open_memstream( &output, &outputLength ) ) == NULL )
+      {
+         break;
+      }
+      if( ( errorStream = open_memstream( &error, &errorLength ) ) == NULL )
+      {
+         fclose( outputStream );
+         free( output );
+         break;
+      }
+
+      response.result = server-> root-> execute( server-> root, ( int ) argc, argv, outputStream, errorStream );
+      fclose( outputStream );
+      fclose( errorStream );
+
+      response.magic = SERVER_PROTOCOL_MAGIC;
+      response.outputLength = ( uint32_t ) outputLength;
+      response.errorLength = ( uint32_t ) errorLength;
+      if( !sendFull( fd, &response, sizeof( response ) ) || !sendFull( fd, output, outputLength ) || !sendFull( fd, error, errorLength ) )
+      {
+         free( output );
+         free( error );
+         break;
+      }
+      free( output );
+      free( error );
+   }
+
+   free( argv );
+   free( buffer );
+   close( fd );
+}
+
+
+static void * work( void *arg )
+{
+const Server *server = arg;
+int fd, flags;
+
+   while( waitReadable( server, server-> listenFd ) )
+   {
+      // The listening socket is non-blocking, so losing the race for a connection to another worker is harmless
+      if( ( fd = accept( server-> listenFd, NULL, NULL ) ) < 0 )
+      {
+         continue;
+      }
+
+      if( ( flags = fcntl( fd, F_GETFL ) ) >= 0 )
+      {
+         fcntl( fd, F_SETFL, flags & ~O_NONBLOCK );
+      }
+      serveConnection( server, fd );
+   }
+
+   return NULL;
+}
+
+
+// Makes way for the socket. Only a stale socket, one nobody answers on any more, is removed: anything else at the path
+// is left alone, so a mistyped path cannot destroy a file or take over a running server.
+static int claimPath( const struct sockaddr_un *address )
+{
+struct stat st;
+int fd;
+bool live;
+
+   if( lstat( address-> sun_path, &st ) < 0 )
+   {
+      return CLI_SUCCESS;
+   }
+
+   if( !S_ISSOCK( st.st_mode ) )
+   {
+      fprintf( stderr, "Error: '%s' exists and is not a socket\n", address-> sun_path );
+      return CLI_ERROR_ALREADY_EXISTS;
+   }
+
+   if( ( fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+   live = connect( fd, ( const struct sockaddr * ) address, sizeof( *address ) ) == 0;
+   close( fd );
+
+   if( live )
+   {
+      fprintf( stderr, "Error: A server is already listening on '%s'\n", address-> sun_path );
+      return CLI_ERROR_ALREADY_EXISTS;
+   }
+
+   unlink( address-> sun_path );
+
+   return CLI_SUCCESS;
+}
+
+
+// Listens on a Unix domain socket and serves parse-and-dispatch requests against the already built tree from a pool
+// of worker threads, until SIGINT, SIGTERM or SIGHUP is received; SIGUSR1 writes the timing figures to stderr
+int runServer( Command_t *root, const char *path, int workerCount )
+{
+struct sockaddr_un address;
+Server server;
+pthread_t *workers;
+sigset_t signals, previous;
+int stopPipe[ 2 ], started, signal, flags, result;
+
+   if( root == NULL || path == NULL || strlen( path ) >= sizeof( address.sun_path ) || workerCount < 1 )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( workers = calloc( ( size_t ) workerCount, sizeof( pthread_t ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   memset( &address, 0, sizeof( address ) );
+   address.sun_family = AF_UNIX;
+   strcpy( address.sun_path, path );
+
+   server.root = root;
+   if( ( server.listenFd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 )
+   {
+      free( workers );
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( ( result = claimPath( &address ) ) != CLI_SUCCESS )
+   {
+      close( server.listenFd );
+      free( workers );
+      return result;
+   }
+   // Requests run handlers with the server's privileges, so only its owner may connect; nobody can before listen()
+   if( bind( server.listenFd, ( struct sockaddr * ) &address, sizeof( address ) ) < 0 || chmod( path, S_IRUSR | S_IWUSR ) < 0
+      || listen( server.listenFd, SOMAXCONN ) < 0 || pipe( stopPipe ) < 0 )
+   {
+      fprintf( stderr, "Error: Cannot listen on '%s'\n", path );
+      close( server.listenFd );
+      free( workers );
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+   if( ( flags = fcntl( server.listenFd, F_GETFL ) ) >= 0 )
+   {
+      fcntl( server.listenFd, F_SETFL, flags | O_NONBLOCK );
+   }
+   server.stopFd = stopPipe[ 0 ];
+
+   // Workers inherit the blocked mask, so the termination signals are only ever taken by sigwait below
+   sigemptyset( &signals );
+   sigaddset( &signals, SIGINT );
+   sigaddset( &signals, SIGTERM );
+   sigaddset( &signals, SIGHUP );
+   sigaddset( &signals, SIGUSR1 );
+   pthread_sigmask( SIG_BLOCK, &signals, &previous );
+
+   for( started = 0; started < workerCount; started++ )
+   {
+      if( pthread_create( &workers[ started ], NULL, work, &server ) != 0 )
+      {
+         break;
+      }
+   }
+
+   if( started > 0 )
+   {
+      while( sigwait( &signals, &signal ) == 0 && signal == SIGUSR1 )
+      {
+         dumpTiming( stderr );
+      }
+   }
+
+   // Closing the write end makes the pipe readable for every worker at once
+   close( stopPipe[ 1 ] );
+   for( int i = 0; i < started; i++ )
+   {
+      pthread_join( workers[ i ], NULL );
+   }
+
+   pthread_sigmask( SIG_SETMASK, &previous, NULL );
+   close( stopPipe[ 0 ] );
+   close( server.listenFd );
+   unlink( path );
+   free( workers );
+
+   return started > 0 ? CLI_SUCCESS : CLI_ERROR_MEMORY;
+}
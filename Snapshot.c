@@ -0,0 +1,1383 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Snapshot.h"
+#include "StaticCommand.h"
+#include "Command.h"
+#include "Argument.h"
+#include "Flag.h"
+#include "Parser.h"
+#include "CLI.h"
+#include "Timing.h"
+
+
+#define SNAPSHOT_VERSION      2
+#define SNAPSHOT_BYTE_ORDER   0x01020304u
+#define SNAPSHOT_NONE         UINT32_MAX
+
+
+static const char magic[ 8 ] = { 'l', 'i', 'b', 'C', 'L', 'I', 's', 'n' };
+
+
+// The file is this header and then its sections, each at an offset aligned to 8 bytes. Everything inside refers to
+// everything else by offset or index, so the image means the same wherever it is mapped. The hash covers all of the
+// file past the header, which catches damage; the tree identifier, given by the caller, catches an intact file written
+// for another tree.
+typedef struct
+{
+   char magic[ 8 ];
+   uint32_t version;
+   uint32_t byteOrder;
+   uint64_t size;
+   uint64_t hash;
+   uint64_t tree;
+   uint32_t commandCount;
+   uint32_t argumentCount;
+   uint32_t flagCount;
+   uint32_t handlerCount;
+   uint32_t commandSlots;
+   uint32_t flagSlots;
+   uint32_t commands;
+   uint32_t arguments;
+   uint32_t flags;
+   uint32_t handlers;
+   uint32_t commandIndex;
+   uint32_t flagIndex;
+   uint32_t strings;
+   uint32_t stringsSize;
+} Header;
+
+
+// Commands are stored breadth first from the root, so the children of each are one run, sorted by name, and every
+// parent comes before its children. Strings are offsets into the string table, SNAPSHOT_NONE for NULL; the handler
+// is an index into the table of handler names.
+typedef struct
+{
+   uint32_t name;
+   uint32_t description;
+   uint32_t handler;
+   uint32_t parent;
+   uint32_t firstChild;
+   uint32_t childCount;
+   uint32_t firstArgument;
+   uint32_t argumentCount;
+   uint32_t firstFlag;
+   uint32_t flagCount;
+} SnapshotCommand;
+
+
+typedef struct
+{
+   uint32_t name;
+   uint32_t description;
+   uint32_t required;
+} SnapshotArgument;
+
+
+typedef struct
+{
+   uint32_t name;
+   uint32_t description;
+   uint32_t shortName;
+   uint32_t command;
+} SnapshotFlag;
+
+
+typedef struct View View;
+
+
+typedef struct
+{
+   CLISnapshot_t interface;
+   const unsigned char *image;
+   size_t size;
+   const Header *header;
+   const SnapshotCommand *commands;
+   const SnapshotArgument *arguments;
+   const SnapshotFlag *flags;
+   const uint32_t *commandIndex;
+   const uint32_t *flagIndex;
+   const char *strings;
+   int ( **handlers )( const CommandContext_t * );
+   _Atomic( View * ) *views;
+} Implementation;
+
+
+// The Command_t of one stored command, made the first time a parse reaches it and kept until the snapshot is
+// deleted. Its arguments and flags are static objects over the mapped strings, in the same allocation.
+struct View
+{
+   Command_t interface;
+   const Implementation *snapshot;
+   const SnapshotCommand *node;
+   uint32_t index;
+   size_t size;
+   Argument_t **arguments;
+   Flag_t **flags;
+   _Atomic( Command_t ** ) children;
+};
+
+
+typedef struct
+{
+   const Command_t *command;
+   int position;
+} Child;
+
+
+typedef struct
+{
+   SnapshotCommand *commands;
+   SnapshotArgument *arguments;
+   SnapshotFlag *flags;
+   const Command_t **queue;
+   char *strings;
+   uint32_t *handlerIds;
+   uint32_t *handlerNames;
+   // Offsets + 1 of the strings stored so far, open-addressed and at most half full, so that each is stored once
+   uint32_t *stringSlots;
+   uint32_t stringSlotCount;
+   uint32_t stringCount;
+   size_t commandCapacity;
+   size_t queueCapacity;
+   size_t argumentCapacity;
+   size_t flagCapacity;
+   size_t stringsSize;
+   size_t stringsCapacity;
+   uint32_t commandCount;
+   uint32_t argumentCount;
+   uint32_t flagCount;
+   uint32_t handlerCount;
+   int result;
+} Builder;
+
+
+// Index keys are a name under an owner: the parent for commands, the command for flags
+static uint32_t hashKey( uint32_t owner, const char *name, size_t length )
+{
+uint32_t hash = 2166136261u ^ ( owner * 0x9e3779b1u );
+
+   for( size_t i = 0; i < length; i++ )
+   {
+      hash ^= ( unsigned char ) name[ i ];
+      hash *= 16777619u;
+   }
+
+   return hash ^ ( hash >> 15 );
+}
+
+
+// A word at a time, so checking a large image costs little more than reading it
+static uint64_t hashImage( const unsigned char *bytes, size_t size )
+{
+uint64_t hash = 14695981039346656037u, word;
+
+   for( size_t i = 0; i + sizeof( word ) <= size; i += sizeof( word ) )
+   {
+      memcpy( &word, bytes + i, sizeof( word ) );
+      hash = ( hash ^ word ) * 1099511628211u;
+      hash ^= hash >> 32;
+   }
+
+   return hash;
+}
+
+
+static uint32_t powerOfTwo( uint32_t n )
+{
+uint32_t power = 1;
+
+   while( power < n )
+   {
+      power <<= 1;
+   }
+
+   return power;
+}
+
+
+static size_t align8( size_t offset )
+{
+   return ( offset + 7 ) & ~( size_t ) 7;
+}
+
+
+static bool equalsToken( const char *str, const char *token, size_t length )
+{
+   return strncmp( str, token, length ) == 0 && str[ length ] == '\0';
+}
+
+
+// Grows one of the builder's arrays to hold `needed` elements; a failure is remembered and reported at the end
+static void * reserveArray( Builder *builder, void *array, size_t *capacity, size_t needed, size_t size )
+{
+size_t grown = *capacity != 0 ? *capacity : 16;
+void *tmp;
+
+   if( needed <= *capacity )
+   {
+      return array;
+   }
+
+   while( grown < needed )
+   {
+      grown *= 2;
+   }
+
+   if( ( tmp = realloc( array, grown * size ) ) == NULL )
+   {
+      builder-> result = CLI_ERROR_MEMORY;
+      return array;
+   }
+
+   *capacity = grown;
+   return tmp;
+}
+
+
+static uint32_t * findString( const Builder *builder, const char *str, size_t length )
+{
+uint32_t mask = builder-> stringSlotCount - 1, slot = hashKey( 0, str, length ) & mask;
+
+   while( builder-> stringSlots[ slot ] != 0 && strcmp( builder-> strings + builder-> stringSlots[ slot ] - 1, str ) != 0 )
+   {
+      slot = ( slot + 1 ) & mask;
+   }
+
+   return &builder-> stringSlots[ slot ];
+}
+
+
+static bool growStringIndex( Builder *builder )
+{
+uint32_t *old = builder-> stringSlots, oldCount = builder-> stringSlotCount;
+
+   builder-> stringSlotCount = oldCount != 0 ? oldCount * 2 : 256;
+   if( ( builder-> stringSlots = calloc( builder-> stringSlotCount, sizeof( uint32_t ) ) ) == NULL )
+   {
+      builder-> stringSlots = old;
+      builder-> stringSlotCount = oldCount;
+      return false;
+   }
+
+   for( uint32_t i = 0; i < oldCount; i++ )
+   {
+      if( old[ i ] != 0 )
+      {
+      const char *str = builder-> strings + old[ i ] - 1;
+
+         *findString( builder, str, strlen( str ) ) = old[ i ];
+      }
+   }
+   free( old );
+
+   return true;
+}
+
+
+// Descriptions and flag names repeat across a large tree, so a string already in the table is not added again
+static uint32_t addString( Builder *builder, const char *str )
+{
+uint32_t *slot;
+size_t length;
+uint32_t offset;
+
+   if( str == NULL || builder-> result != CLI_SUCCESS )
+   {
+      return SNAPSHOT_NONE;
+   }
+
+   if( builder-> stringCount * 2 >= builder-> stringSlotCount && !growStringIndex( builder ) )
+   {
+      builder-> result = CLI_ERROR_MEMORY;
+      return SNAPSHOT_NONE;
+   }
+
+   length = strlen( str );
+   if( *( slot = findString( builder, str, length ) ) != 0 )
+   {
+      return *slot - 1;
+   }
+
+   length++;
+   if( builder-> stringsSize + length >= SNAPSHOT_NONE )
+   {
+      builder-> result = CLI_ERROR_INVALID_ARGUMENT;
+      return SNAPSHOT_NONE;
+   }
+
+   builder-> strings = reserveArray( builder, builder-> strings, &builder-> stringsCapacity, builder-> stringsSize + length, 1 );
+   if( builder-> result != CLI_SUCCESS )
+   {
+      return SNAPSHOT_NONE;
+   }
+
+   memcpy( builder-> strings + builder-> stringsSize, str, length );
+   offset = ( uint32_t ) builder-> stringsSize;
+   builder-> stringsSize += length;
+   *slot = offset + 1;
+   builder-> stringCount++;
+
+   return offset;
+}
+
+
+// Handlers are stored by the name the bindings give them; one without a binding cannot be stored
+static uint32_t addHandler( Builder *builder, int ( *handler )( const CommandContext_t * ), const CLIHandlerBinding_t *bindings, int bindingCount )
+{
+   if( handler == NULL )
+   {
+      return SNAPSHOT_NONE;
+   }
+
+   for( int b = 0; b < bindingCount; b++ )
+   {
+      if( bindings[ b ].handler == handler && bindings[ b ].name != NULL )
+      {
+         if( builder-> handlerIds[ b ] == SNAPSHOT_NONE )
+         {
+            builder-> handlerNames[ builder-> handlerCount ] = addString( builder, bindings[ b ].name );
+            builder-> handlerIds[ b ] = builder-> handlerCount++;
+         }
+         return builder-> handlerIds[ b ];
+      }
+   }
+
+   builder-> result = CLI_ERROR_NOT_FOUND;
+   return SNAPSHOT_NONE;
+}
+
+
+static int compareChildren( const void *a, const void *b )
+{
+const Child *left = a, *right = b;
+int result = strcmp( left-> command-> getName( left-> command ), right-> command-> getName( right-> command ) );
+
+   return result != 0 ? result : ( left-> position > right-> position ) - ( left-> position < right-> position );
+}
+
+
+// Fills in one command, already queued, and queues its children sorted by name; equal names keep their order
+static void addCommand( Builder *builder, uint32_t index, const CLIHandlerBinding_t *bindings, int bindingCount, Child **scratch, size_t *scratchCapacity )
+{
+const Command_t *command = builder-> queue[ index ];
+SnapshotCommand *node;
+Command_t **children = command-> getSubCommands( command );
+Argument_t **arguments = command-> getArguments( command );
+Flag_t **flags = command-> getFlags( command );
+int childCount = command-> getSubCommandCount( command ), argumentCount = command-> getArgumentCount( command ), flagCount = command-> getFlagCount( command );
+
+   if( children == NULL && childCount > 0 )
+   {
+      builder-> result = CLI_ERROR_MEMORY;
+      return;
+   }
+   builder-> commands = reserveArray( builder, builder-> commands, &builder-> commandCapacity, builder-> commandCount + ( size_t ) childCount, sizeof( SnapshotCommand ) );
+   builder-> queue = reserveArray( builder, builder-> queue, &builder-> queueCapacity, builder-> commandCount + ( size_t ) childCount, sizeof( Command_t * ) );
+   builder-> arguments = reserveArray( builder, builder-> arguments, &builder-> argumentCapacity, builder-> argumentCount + ( size_t ) argumentCount, sizeof( SnapshotArgument ) );
+   builder-> flags = reserveArray( builder, builder-> flags, &builder-> flagCapacity, builder-> flagCount + ( size_t ) flagCount, sizeof( SnapshotFlag ) );
+   *scratch = reserveArray( builder, *scratch, scratchCapacity, ( size_t ) childCount, sizeof( Child ) );
+   if( builder-> result != CLI_SUCCESS )
+   {
+      return;
+   }
+
+   node = &builder-> commands[ index ];
+   node-> name = addString( builder, command-> getName( command ) );
+   node-> description = addString( builder, command-> getDescription( command ) );
+   node-> handler = addHandler( builder, command-> getHandler( command ), bindings, bindingCount );
+   node-> parent = index == 0 ? SNAPSHOT_NONE : node-> parent;
+   node-> firstChild = builder-> commandCount;
+   node-> childCount = ( uint32_t ) childCount;
+   node-> firstArgument = builder-> argumentCount;
+   node-> argumentCount = ( uint32_t ) argumentCount;
+   node-> firstFlag = builder-> flagCount;
+   node-> flagCount = ( uint32_t ) flagCount;
+
+   for( int i = 0; i < argumentCount; i++ )
+   {
+   SnapshotArgument *argument = &builder-> arguments[ builder-> argumentCount++ ];
+
+      argument-> name = addString( builder, arguments[ i ]-> getName( arguments[ i ] ) );
+      argument-> description = addString( builder, arguments[ i ]-> getDescription( arguments[ i ] ) );
+      argument-> required = arguments[ i ]-> isRequired( arguments[ i ] );
+   }
+
+   for( int i = 0; i < flagCount; i++ )
+   {
+   SnapshotFlag *flag = &builder-> flags[ builder-> flagCount++ ];
+
+      flag-> name = addString( builder, flags[ i ]-> getName( flags[ i ] ) );
+      flag-> description = addString( builder, flags[ i ]-> getDescription( flags[ i ] ) );
+      flag-> shortName = ( unsigned char ) flags[ i ]-> getShortName( flags[ i ] );
+      flag-> command = index;
+   }
+
+   for( int i = 0; i < childCount; i++ )
+   {
+      ( *scratch )[ i ].command = children[ i ];
+      ( *scratch )[ i ].position = i;
+   }
+   qsort( *scratch, ( size_t ) childCount, sizeof( Child ), compareChildren );
+   for( int i = 0; i < childCount; i++ )
+   {
+      builder-> queue[ builder-> commandCount ] = ( *scratch )[ i ].command;
+      builder-> commands[ builder-> commandCount ].parent = index;
+      builder-> commandCount++;
+   }
+}
+
+
+// Open addressing with linear probing, at most half full; the first entry under a key wins, as with the runtime indexes
+static void insertKey( uint32_t *slots, uint32_t slotCount, uint32_t hash, uint32_t entry, bool ( *same )( const Builder *, uint32_t, uint32_t ), const Builder *builder )
+{
+uint32_t slot = hash & ( slotCount - 1 );
+
+   while( slots[ slot ] != 0 )
+   {
+      if( same( builder, slots[ slot ] - 1, entry ) )
+      {
+         return;
+      }
+      slot = ( slot + 1 ) & ( slotCount - 1 );
+   }
+
+   slots[ slot ] = entry + 1;
+}
+
+
+static bool sameCommand( const Builder *builder, uint32_t a, uint32_t b )
+{
+   return builder-> commands[ a ].parent == builder-> commands[ b ].parent && strcmp( builder-> strings + builder-> commands[ a ].name, builder-> strings + builder-> commands[ b ].name ) == 0;
+}
+
+
+static bool sameFlag( const Builder *builder, uint32_t a, uint32_t b )
+{
+   return builder-> flags[ a ].command == builder-> flags[ b ].command && strcmp( builder-> strings + builder-> flags[ a ].name, builder-> strings + builder-> flags[ b ].name ) == 0;
+}
+
+
+// Lays the sections out behind the header and writes the image to a temporary file renamed over `path`, so that
+// processes which have the old snapshot mapped keep reading it undisturbed
+static int writeImage( const Builder *builder, const char *path, uint64_t tree )
+{
+Header header = { { 0 }, SNAPSHOT_VERSION, SNAPSHOT_BYTE_ORDER, 0, 0, tree, builder-> commandCount, builder-> argumentCount, builder-> flagCount, builder-> handlerCount, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+size_t offset, length;
+unsigned char *image;
+uint32_t *slots;
+char *temporary;
+int fd, result = CLI_SUCCESS;
+
+   memcpy( header.magic, magic, sizeof( magic ) );
+   header.commandSlots = powerOfTwo( builder-> commandCount * 2 );
+   header.flagSlots = powerOfTwo( builder-> flagCount * 2 + 1 );
+   header.stringsSize = ( uint32_t ) builder-> stringsSize;
+
+   offset = align8( sizeof( Header ) );
+   header.commands = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( SnapshotCommand ) * builder-> commandCount );
+   header.arguments = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( SnapshotArgument ) * builder-> argumentCount );
+   header.flags = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( SnapshotFlag ) * builder-> flagCount );
+   header.handlers = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( uint32_t ) * builder-> handlerCount );
+   header.commandIndex = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( uint32_t ) * header.commandSlots );
+   header.flagIndex = ( uint32_t ) offset;
+   offset = align8( offset + sizeof( uint32_t ) * header.flagSlots );
+   header.strings = ( uint32_t ) offset;
+   offset = align8( offset + builder-> stringsSize );
+   if( offset >= SNAPSHOT_NONE )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+   header.size = offset;
+
+   if( ( image = calloc( 1, offset ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   memcpy( image + header.commands, builder-> commands, sizeof( SnapshotCommand ) * builder-> commandCount );
+   memcpy( image + header.arguments, builder-> arguments, sizeof( SnapshotArgument ) * builder-> argumentCount );
+   memcpy( image + header.flags, builder-> flags, sizeof( SnapshotFlag ) * builder-> flagCount );
+   memcpy( image + header.handlers, builder-> handlerNames, sizeof( uint32_t ) * builder-> handlerCount );
+   memcpy( image + header.strings, builder-> strings, builder-> stringsSize );
+
+   slots = ( uint32_t * )( void * )( image + header.commandIndex );
+   for( uint32_t i = 1; i < builder-> commandCount; i++ )
+   {
+   const char *name = builder-> strings + builder-> commands[ i ].name;
+
+      insertKey( slots, header.commandSlots, hashKey( builder-> commands[ i ].parent, name, strlen( name ) ), i, sameCommand, builder );
+   }
+
+   slots = ( uint32_t * )( void * )( image + header.flagIndex );
+   for( uint32_t i = 0; i < builder-> commandCount; i++ )
+   {
+      for( uint32_t f = builder-> commands[ i ].firstFlag; f < builder-> commands[ i ].firstFlag + builder-> commands[ i ].flagCount; f++ )
+      {
+      const char *name = builder-> strings + builder-> flags[ f ].name;
+
+         insertKey( slots, header.flagSlots, hashKey( i, name, strlen( name ) ), f, sameFlag, builder );
+      }
+   }
+
+   header.hash = hashImage( image + sizeof( Header ), offset - sizeof( Header ) );
+   memcpy( image, &header, sizeof( Header ) );
+
+   length = strlen( path ) + sizeof( ".XXXXXX" );
+   if( ( temporary = malloc( length ) ) == NULL )
+   {
+      free( image );
+      return CLI_ERROR_MEMORY;
+   }
+   snprintf( temporary, length, "%s.XXXXXX", path );
+
+   if( ( fd = mkstemp( temporary ) ) < 0 )
+   {
+      result = CLI_ERROR_INVALID_ARGUMENT;
+   }
+   else
+   {
+      if( fchmod( fd, 0644 ) != 0 || write( fd, image, offset ) != ( ssize_t ) offset )
+      {
+         result = CLI_ERROR_INVALID_ARGUMENT;
+      }
+      if( close( fd ) != 0 || ( result == CLI_SUCCESS && rename( temporary, path ) != 0 ) )
+      {
+         result = CLI_ERROR_INVALID_ARGUMENT;
+      }
+      if( result != CLI_SUCCESS )
+      {
+         unlink( temporary );
+      }
+   }
+
+   free( temporary );
+   free( image );
+
+   return result;
+}
+
+
+// Writes the tree below root, runtime or static, to a snapshot file stamped with the tree identifier. Every handler in
+// it must have a binding.
+int writeSnapshot( const Command_t *root, const char *path, uint64_t tree, const CLIHandlerBinding_t *bindings, int bindingCount )
+{
+Builder builder = { 0 };
+Child *scratch = NULL;
+size_t scratchCapacity = 0;
+int result;
+
+   if( root == NULL || path == NULL || bindingCount < 0 || ( bindings == NULL && bindingCount > 0 ) )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   builder.result = CLI_SUCCESS;
+   builder.handlerIds = malloc( sizeof( uint32_t ) * ( size_t )( bindingCount + 1 ) );
+   builder.handlerNames = malloc( sizeof( uint32_t ) * ( size_t )( bindingCount + 1 ) );
+   builder.commands = reserveArray( &builder, NULL, &builder.commandCapacity, 1, sizeof( SnapshotCommand ) );
+   builder.queue = reserveArray( &builder, NULL, &builder.queueCapacity, 1, sizeof( Command_t * ) );
+   if( builder.handlerIds == NULL || builder.handlerNames == NULL || builder.result != CLI_SUCCESS )
+   {
+      builder.result = CLI_ERROR_MEMORY;
+   }
+   else
+   {
+      memset( builder.handlerIds, 0xff, sizeof( uint32_t ) * ( size_t )( bindingCount + 1 ) );
+      builder.queue[ 0 ] = root;
+      builder.commandCount = 1;
+   }
+
+   for( uint32_t i = 0; i < builder.commandCount && builder.result == CLI_SUCCESS; i++ )
+   {
+      addCommand( &builder, i, bindings, bindingCount, &scratch, &scratchCapacity );
+   }
+
+   // An empty string table still needs its terminator, which validation relies on
+   if( builder.result == CLI_SUCCESS && builder.stringsSize == 0 )
+   {
+      addString( &builder, "" );
+   }
+
+   result = builder.result == CLI_SUCCESS ? writeImage( &builder, path, tree ) : builder.result;
+
+   free( scratch );
+   free( builder.commands );
+   free( builder.queue );
+   free( builder.arguments );
+   free( builder.flags );
+   free( builder.strings );
+   free( builder.handlerIds );
+   free( builder.handlerNames );
+   free( builder.stringSlots );
+
+   return result;
+}
+
+
+// NULL for an absent string, and for an offset past the table, which only a damaged file holds
+static const char * string( const Implementation *impl, uint32_t offset )
+{
+   return offset < impl-> header-> stringsSize ? impl-> strings + offset : NULL;
+}
+
+
+// Names compared before their record is checked; one out of bounds matches nothing but the empty name
+static const char * nameAt( const Implementation *impl, uint32_t offset )
+{
+const char *name = string( impl, offset );
+
+   return name != NULL ? name : "";
+}
+
+
+static uint32_t lookupCommand( const Implementation *impl, uint32_t parent, const char *name, size_t length )
+{
+uint32_t mask = impl-> header-> commandSlots - 1, slot = hashKey( parent, name, length ) & mask, entry;
+
+   for( uint32_t probes = 0; probes <= mask && ( entry = impl-> commandIndex[ slot ] ) != 0 && entry <= impl-> header-> commandCount; probes++, slot = ( slot + 1 ) & mask )
+   {
+      if( impl-> commands[ entry - 1 ].parent == parent && equalsToken( nameAt( impl, impl-> commands[ entry - 1 ].name ), name, length ) )
+      {
+         return entry - 1;
+      }
+   }
+
+   return SNAPSHOT_NONE;
+}
+
+
+static uint32_t lookupFlag( const Implementation *impl, uint32_t command, const char *name, size_t length )
+{
+uint32_t mask = impl-> header-> flagSlots - 1, slot = hashKey( command, name, length ) & mask, entry;
+
+   for( uint32_t probes = 0; probes <= mask && ( entry = impl-> flagIndex[ slot ] ) != 0 && entry <= impl-> header-> flagCount; probes++, slot = ( slot + 1 ) & mask )
+   {
+      if( impl-> flags[ entry - 1 ].command == command && equalsToken( nameAt( impl, impl-> flags[ entry - 1 ].name ), name, length ) )
+      {
+         return entry - 1;
+      }
+   }
+
+   return SNAPSHOT_NONE;
+}
+
+
+static View * viewOf( const Implementation *impl, uint32_t index );
+
+
+static const char * viewGetName( const Command_t *self )
+{
+View *view;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   return string( view-> snapshot, view-> node-> name );
+}
+
+
+static const char * viewGetDescription( const Command_t *self )
+{
+View *view;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   return string( view-> snapshot, view-> node-> description );
+}
+
+
+static Argument_t ** viewGetArguments( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, View, interface )-> arguments : NULL;
+}
+
+
+static int viewGetArgumentCount( const Command_t *self )
+{
+   return self != NULL ? ( int ) __containerof( self, View, interface )-> node-> argumentCount : 0;
+}
+
+
+static Flag_t ** viewGetFlags( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, View, interface )-> flags : NULL;
+}
+
+
+static int viewGetFlagCount( const Command_t *self )
+{
+   return self != NULL ? ( int ) __containerof( self, View, interface )-> node-> flagCount : 0;
+}
+
+
+// The list of children is only needed for help and listings, so it is made on first use, like the views in it
+static Command_t ** viewGetSubCommands( const Command_t *self )
+{
+View *view;
+Command_t **children, **expected = NULL;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   if( ( children = atomic_load_explicit( &view-> children, memory_order_acquire ) ) != NULL || view-> node-> childCount == 0 )
+   {
+      return children;
+   }
+
+   if( ( children = malloc( sizeof( Command_t * ) * view-> node-> childCount ) ) == NULL )
+   {
+      return NULL;
+   }
+   for( uint32_t i = 0; i < view-> node-> childCount; i++ )
+   {
+   View *child;
+
+      if( ( child = viewOf( view-> snapshot, view-> node-> firstChild + i ) ) == NULL )
+      {
+         free( children );
+         return NULL;
+      }
+      children[ i ] = &child-> interface;
+   }
+
+   if( !atomic_compare_exchange_strong_explicit( &view-> children, &expected, children, memory_order_acq_rel, memory_order_acquire ) )
+   {
+      free( children );
+      return expected;
+   }
+
+   return children;
+}
+
+
+static int viewGetSubCommandCount( const Command_t *self )
+{
+   return self != NULL ? ( int ) __containerof( self, View, interface )-> node-> childCount : 0;
+}
+
+
+// Children are stored sorted, so this reads the name straight from the image without making the child's view
+static const char * viewGetSubCommandNameInOrder( const Command_t *self, int position )
+{
+View *view;
+
+   if( self == NULL || position < 0 || ( uint32_t ) position >= ( view = __containerof( self, View, interface ) )-> node-> childCount )
+   {
+      return NULL;
+   }
+
+   return nameAt( view-> snapshot, view-> snapshot-> commands[ view-> node-> firstChild + ( uint32_t ) position ].name );
+}
+
+
+static void viewForEachSubCommand( const Command_t *self, bool ( *cb )( Command_t *, void * ), void *userData )
+{
+View *view, *child;
+
+   if( self == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   view = __containerof( self, View, interface );
+   for( uint32_t i = 0; i < view-> node-> childCount; i++ )
+   {
+      if( ( child = viewOf( view-> snapshot, view-> node-> firstChild + i ) ) == NULL || !cb( &child-> interface, userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// Children are stored sorted, so the matches are one run found by binary search
+static void viewForEachSubCommandWithPrefix( const Command_t *self, const char *prefix, size_t length, bool ( *cb )( Command_t *, void * ), void *userData )
+{
+View *view, *child;
+uint32_t low, high, middle;
+
+   if( self == NULL || prefix == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   view = __containerof( self, View, interface );
+   low = view-> node-> firstChild;
+   high = low + view-> node-> childCount;
+   while( low < high )
+   {
+      middle = low + ( high - low ) / 2;
+      if( strncmp( nameAt( view-> snapshot, view-> snapshot-> commands[ middle ].name ), prefix, length ) < 0 )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+
+   for( high = view-> node-> firstChild + view-> node-> childCount; low < high && strncmp( nameAt( view-> snapshot, view-> snapshot-> commands[ low ].name ), prefix, length ) == 0; low++ )
+   {
+      if( ( child = viewOf( view-> snapshot, low ) ) == NULL || !cb( &child-> interface, userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// The writer sorts every level
+static bool viewIsSorted( const Command_t *self )
+{
+   ( void ) self;
+
+   return true;
+}
+
+
+static Command_t * viewFindSubCommand( const Command_t *self, const char *name, size_t length )
+{
+View *view, *child;
+uint32_t index;
+
+   if( self == NULL || name == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   if( ( index = lookupCommand( view-> snapshot, view-> index, name, length ) ) == SNAPSHOT_NONE || ( child = viewOf( view-> snapshot, index ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   return &child-> interface;
+}
+
+
+static Command_t * viewGetParent( const Command_t *self )
+{
+View *view, *parent;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   if( view-> node-> parent == SNAPSHOT_NONE || ( parent = viewOf( view-> snapshot, view-> node-> parent ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   return &parent-> interface;
+}
+
+
+static int ( *viewGetHandler( const Command_t *self ) )( const CommandContext_t * )
+{
+View *view;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   view = __containerof( self, View, interface );
+   return view-> node-> handler != SNAPSHOT_NONE ? view-> snapshot-> handlers[ view-> node-> handler ] : NULL;
+}
+
+
+static int viewFindFlag( const Command_t *self, const char *name, size_t length )
+{
+View *view;
+uint32_t index;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   view = __containerof( self, View, interface );
+   index = lookupFlag( view-> snapshot, view-> index, name, length );
+   return index != SNAPSHOT_NONE && index - view-> node-> firstFlag < view-> node-> flagCount ? ( int )( index - view-> node-> firstFlag ) : -1;
+}
+
+
+static int viewFindShortFlag( const Command_t *self, char shortName )
+{
+View *view;
+
+   if( self == NULL || shortName == '\0' )
+   {
+      return -1;
+   }
+
+   view = __containerof( self, View, interface );
+   for( uint32_t i = 0; i < view-> node-> flagCount; i++ )
+   {
+      if( view-> snapshot-> flags[ view-> node-> firstFlag + i ].shortName == ( unsigned char ) shortName )
+      {
+         return ( int ) i;
+      }
+   }
+
+   return -1;
+}
+
+
+static int viewFindArgument( const Command_t *self, const char *name, size_t length )
+{
+View *view;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   view = __containerof( self, View, interface );
+   for( uint32_t i = 0; i < view-> node-> argumentCount; i++ )
+   {
+      if( equalsToken( nameAt( view-> snapshot, view-> snapshot-> arguments[ view-> node-> firstArgument + i ].name ), name, length ) )
+      {
+         return ( int ) i;
+      }
+   }
+
+   return -1;
+}
+
+
+// The image itself is mapped, not allocated; only the views made so far count
+static void viewMeasure( const Command_t *self, CLIMemoryReport_t *report )
+{
+View *view;
+
+   if( self == NULL || report == NULL )
+   {
+      return;
+   }
+
+   view = __containerof( self, View, interface );
+   addMemoryUsage( &report-> commands, view-> size );
+   if( atomic_load_explicit( &view-> children, memory_order_acquire ) != NULL )
+   {
+      addMemoryUsage( &report-> arrays, sizeof( Command_t * ) * view-> node-> childCount );
+   }
+}
+
+
+static bool validSection( const Implementation *impl, uint32_t offset, uint64_t count, size_t size )
+{
+   return offset >= sizeof( Header ) && offset % 8 == 0 && offset <= impl-> size && count * size <= impl-> size - offset;
+}
+
+
+static bool validString( const Implementation *impl, uint32_t offset, bool optional )
+{
+   return offset < impl-> header-> stringsSize || ( optional && offset == SNAPSHOT_NONE );
+}
+
+
+static bool validRange( uint32_t first, uint32_t count, uint32_t total )
+{
+   return ( uint64_t ) first + count <= total;
+}
+
+
+// A command is checked when its view is made, so that opening touches only the header and a parse only the records on
+// its path. Parents come first, so walking up from any command ends at the root.
+static bool validCommand( const Implementation *impl, uint32_t index )
+{
+const Header *header = impl-> header;
+const SnapshotCommand *command = &impl-> commands[ index ];
+
+   if( !validString( impl, command-> name, false ) || !validString( impl, command-> description, true )
+      || ( command-> handler != SNAPSHOT_NONE && command-> handler >= header-> handlerCount )
+      || ( index == 0 ? command-> parent != SNAPSHOT_NONE : command-> parent >= index )
+      || !validRange( command-> firstChild, command-> childCount, header-> commandCount )
+      || !validRange( command-> firstArgument, command-> argumentCount, header-> argumentCount )
+      || !validRange( command-> firstFlag, command-> flagCount, header-> flagCount ) )
+   {
+      return false;
+   }
+
+   for( uint32_t i = command-> firstArgument; i < command-> firstArgument + command-> argumentCount; i++ )
+   {
+      if( !validString( impl, impl-> arguments[ i ].name, false ) || !validString( impl, impl-> arguments[ i ].description, true ) )
+      {
+         return false;
+      }
+   }
+
+   for( uint32_t i = command-> firstFlag; i < command-> firstFlag + command-> flagCount; i++ )
+   {
+      if( !validString( impl, impl-> flags[ i ].name, false ) || !validString( impl, impl-> flags[ i ].description, true )
+         || impl-> flags[ i ].shortName > 255 || impl-> flags[ i ].command != index )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+// One allocation: the view, then the static argument and flag objects, then the two lists pointing at them
+static View * newView( const Implementation *impl, uint32_t index )
+{
+const SnapshotCommand *node = &impl-> commands[ index ];
+size_t size = sizeof( View ) + ( sizeof( StaticArgument_t ) + sizeof( Argument_t * ) ) * node-> argumentCount + ( sizeof( StaticFlag_t ) + sizeof( Flag_t * ) ) * node-> flagCount;
+StaticArgument_t *arguments;
+StaticFlag_t *flags;
+View *self;
+
+   if( !validCommand( impl, index ) || ( self = calloc( 1, size ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   arguments = ( StaticArgument_t * )( void * )( self + 1 );
+   flags = ( StaticFlag_t * )( void * )( arguments + node-> argumentCount );
+   self-> arguments = ( Argument_t ** )( void * )( flags + node-> flagCount );
+   self-> flags = ( Flag_t ** )( void * )( self-> arguments + node-> argumentCount );
+   self-> snapshot = impl;
+   self-> node = node;
+   self-> index = index;
+   self-> size = size;
+
+   for( uint32_t i = 0; i < node-> argumentCount; i++ )
+   {
+   const SnapshotArgument *argument = &impl-> arguments[ node-> firstArgument + i ];
+
+      arguments[ i ] = ( StaticArgument_t ) CLI_STATIC_ARGUMENT( string( impl, argument-> name ), string( impl, argument-> description ), argument-> required != 0 );
+      self-> arguments[ i ] = &arguments[ i ].interface;
+   }
+
+   for( uint32_t i = 0; i < node-> flagCount; i++ )
+   {
+   const SnapshotFlag *flag = &impl-> flags[ node-> firstFlag + i ];
+
+      flags[ i ] = ( StaticFlag_t ) CLI_STATIC_FLAG( string( impl, flag-> name ), ( char ) flag-> shortName, string( impl, flag-> description ) );
+      self-> flags[ i ] = &flags[ i ].interface;
+   }
+
+   // Views are as read-only as static commands, so they share the functions that refuse changes and render help
+   self-> interface.addSubCommand = staticCommandAddSubCommand;
+   self-> interface.addArgument = staticCommandAddArgument;
+   self-> interface.addFlag = staticCommandAddFlag;
+   self-> interface.reserve = staticCommandReserve;
+   self-> interface.parse = staticCommandParse;
+   self-> interface.execute = staticCommandExecute;
+   self-> interface.delete = staticCommandDelete;
+   self-> interface.getName = viewGetName;
+   self-> interface.getDescription = viewGetDescription;
+   self-> interface.getArguments = viewGetArguments;
+   self-> interface.getArgumentCount = viewGetArgumentCount;
+   self-> interface.getFlags = viewGetFlags;
+   self-> interface.getFlagCount = viewGetFlagCount;
+   self-> interface.getSubCommands = viewGetSubCommands;
+   self-> interface.getSubCommandCount = viewGetSubCommandCount;
+   self-> interface.getSubCommandNameInOrder = viewGetSubCommandNameInOrder;
+   self-> interface.printHelp = staticCommandPrintHelp;
+   self-> interface.forEachSubCommand = viewForEachSubCommand;
+   self-> interface.forEachSubCommandWithPrefix = viewForEachSubCommandWithPrefix;
+   self-> interface.forEachFlagWithPrefix = staticCommandForEachFlagWithPrefix;
+   self-> interface.findSubCommand = viewFindSubCommand;
+   self-> interface.freeze = staticCommandFreeze;
+   self-> interface.getParent = viewGetParent;
+   self-> interface.getHandler = viewGetHandler;
+   self-> interface.isSorted = viewIsSorted;
+   self-> interface.findFlag = viewFindFlag;
+   self-> interface.findShortFlag = viewFindShortFlag;
+   self-> interface.findArgument = viewFindArgument;
+   self-> interface.measure = viewMeasure;
+
+   return self;
+}
+
+
+// Concurrent parses may reach the same command at once: one view wins and the others are dropped
+static View * viewOf( const Implementation *impl, uint32_t index )
+{
+View *view, *expected = NULL;
+
+   if( ( view = atomic_load_explicit( &impl-> views[ index ], memory_order_acquire ) ) != NULL )
+   {
+      return view;
+   }
+
+   if( ( view = newView( impl, index ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   if( !atomic_compare_exchange_strong_explicit( &impl-> views[ index ], &expected, view, memory_order_acq_rel, memory_order_acquire ) )
+   {
+      free( view );
+      return expected;
+   }
+
+   return view;
+}
+
+
+// Opening checks the header alone, and that the sections it names lie within the file: the records are checked as
+// they are used, so a damaged or foreign file is refused rather than read out of bounds, without touching every page.
+static bool validHeader( Implementation *impl, uint64_t tree )
+{
+const Header *header = ( const Header * )( const void * ) impl-> image;
+
+   if( impl-> size < sizeof( Header ) || impl-> size % 8 != 0 || memcmp( header-> magic, magic, sizeof( magic ) ) != 0
+      || header-> version != SNAPSHOT_VERSION || header-> byteOrder != SNAPSHOT_BYTE_ORDER || header-> size != impl-> size
+      || header-> tree != tree )
+   {
+      return false;
+   }
+
+   impl-> header = header;
+   if( header-> commandCount == 0 || header-> commandSlots == 0 || ( header-> commandSlots & ( header-> commandSlots - 1 ) ) != 0
+      || header-> flagSlots == 0 || ( header-> flagSlots & ( header-> flagSlots - 1 ) ) != 0 || header-> stringsSize == 0
+      || !validSection( impl, header-> commands, header-> commandCount, sizeof( SnapshotCommand ) )
+      || !validSection( impl, header-> arguments, header-> argumentCount, sizeof( SnapshotArgument ) )
+      || !validSection( impl, header-> flags, header-> flagCount, sizeof( SnapshotFlag ) )
+      || !validSection( impl, header-> handlers, header-> handlerCount, sizeof( uint32_t ) )
+      || !validSection( impl, header-> commandIndex, header-> commandSlots, sizeof( uint32_t ) )
+      || !validSection( impl, header-> flagIndex, header-> flagSlots, sizeof( uint32_t ) )
+      || !validSection( impl, header-> strings, header-> stringsSize, 1 ) )
+   {
+      return false;
+   }
+
+   impl-> commands = ( const SnapshotCommand * )( const void * )( impl-> image + header-> commands );
+   impl-> arguments = ( const SnapshotArgument * )( const void * )( impl-> image + header-> arguments );
+   impl-> flags = ( const SnapshotFlag * )( const void * )( impl-> image + header-> flags );
+   impl-> commandIndex = ( const uint32_t * )( const void * )( impl-> image + header-> commandIndex );
+   impl-> flagIndex = ( const uint32_t * )( const void * )( impl-> image + header-> flagIndex );
+   impl-> strings = ( const char * )( impl-> image + header-> strings );
+
+   // A terminated table ends every string in it, wherever an offset points
+   return impl-> strings[ header-> stringsSize - 1 ] == '\0';
+}
+
+
+// Reads the whole image: its hash, and every record and index slot, so that damage is found before a parse reaches
+// it. Opening does none of this, which is what keeps it independent of the size of the tree.
+static bool verify( const CLISnapshot_t *self )
+{
+const Implementation *impl;
+
+   if( self == NULL )
+   {
+      return false;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   if( impl-> header-> hash != hashImage( impl-> image + sizeof( Header ), impl-> size - sizeof( Header ) ) )
+   {
+      return false;
+   }
+
+   for( uint32_t i = 0; i < impl-> header-> commandCount; i++ )
+   {
+      if( !validCommand( impl, i ) )
+      {
+         return false;
+      }
+   }
+
+   for( uint32_t i = 0; i < impl-> header-> commandSlots; i++ )
+   {
+      if( impl-> commandIndex[ i ] > impl-> header-> commandCount )
+      {
+         return false;
+      }
+   }
+
+   for( uint32_t i = 0; i < impl-> header-> flagSlots; i++ )
+   {
+      if( impl-> flagIndex[ i ] > impl-> header-> flagCount )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+// Every handler name in the image must have a binding in this build; one that does not means the snapshot is stale
+static bool bindHandlers( Implementation *impl, const CLIHandlerBinding_t *bindings, int bindingCount )
+{
+const uint32_t *names = ( const uint32_t * )( const void * )( impl-> image + impl-> header-> handlers );
+
+   if( ( impl-> handlers = calloc( impl-> header-> handlerCount + 1, sizeof( *impl-> handlers ) ) ) == NULL )
+   {
+      return false;
+   }
+
+   for( uint32_t h = 0; h < impl-> header-> handlerCount; h++ )
+   {
+      if( !validString( impl, names[ h ], false ) )
+      {
+         return false;
+      }
+      for( int b = 0; b < bindingCount && impl-> handlers[ h ] == NULL; b++ )
+      {
+         if( bindings[ b ].name != NULL && strcmp( bindings[ b ].name, impl-> strings + names[ h ] ) == 0 )
+         {
+            impl-> handlers[ h ] = bindings[ b ].handler;
+         }
+      }
+      if( impl-> handlers[ h ] == NULL )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+static Command_t * getRoot( const CLISnapshot_t *self )
+{
+View *root;
+
+   if( self == NULL )
+   {
+      return NULL;
+   }
+
+   root = viewOf( __containerof( self, Implementation, interface ), 0 );
+   return root != NULL ? &root-> interface : NULL;
+}
+
+
+static int parseTokens( const CLISnapshot_t *self, int argc, const char *const argv[] )
+{
+Command_t *root;
+
+   if( ( root = getRoot( self ) ) == NULL )
+   {
+      return self != NULL ? CLI_ERROR_MEMORY : CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   return executeCommand( root, argc, argv, stdout, stderr );
+}
+
+
+static int parse( const CLISnapshot_t *self, int argc, char *argv[] )
+{
+   return parseTokens( self, argc, ( const char *const * ) argv );
+}
+
+
+static void delete( CLISnapshot_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   if( impl-> views != NULL )
+   {
+      for( uint32_t i = 0; i < impl-> header-> commandCount; i++ )
+      {
+      View *view = atomic_load_explicit( &impl-> views[ i ], memory_order_acquire );
+
+         if( view != NULL )
+         {
+            free( atomic_load_explicit( &view-> children, memory_order_acquire ) );
+            free( view );
+         }
+      }
+      free( impl-> views );
+   }
+   free( impl-> handlers );
+   munmap( ( void * )( uintptr_t ) impl-> image, impl-> size );
+   free( impl );
+   *selfPtr = NULL;
+}
+
+
+// Maps a snapshot written by writeSnapshot and parses against it in place. Returns NULL if the file cannot be read,
+// was written by another version or byte order or for another tree, has a header naming sections outside it, or
+// names a handler the bindings do not have; the caller then builds the tree as usual, and may write a fresh snapshot.
+CLISnapshot_t * openSnapshot( const char *path, uint64_t tree, const CLIHandlerBinding_t *bindings, int bindingCount )
+{
+Implementation *self;
+struct stat st;
+void *image;
+int fd;
+
+   if( path == NULL || bindingCount < 0 || ( bindings == NULL && bindingCount > 0 ) )
+   {
+      return NULL;
+   }
+
+   if( ( fd = open( path, O_RDONLY | O_CLOEXEC ) ) < 0 )
+   {
+      return NULL;
+   }
+   if( fstat( fd, &st ) != 0 || st.st_size < ( off_t ) sizeof( Header ) || ( uint64_t ) st.st_size >= SNAPSHOT_NONE
+      || ( image = mmap( NULL, ( size_t ) st.st_size, PROT_READ, MAP_SHARED, fd, 0 ) ) == MAP_FAILED )
+   {
+      close( fd );
+      return NULL;
+   }
+   close( fd );
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      munmap( image, ( size_t ) st.st_size );
+      return NULL;
+   }
+
+   self-> image = image;
+   self-> size = ( size_t ) st.st_size;
+   self-> interface.getRoot = getRoot;
+   self-> interface.parse = parse;
+   self-> interface.parseTokens = parseTokens;
+   self-> interface.verify = verify;
+   self-> interface.delete = delete;
+
+   if( !validHeader( self, tree ) || !bindHandlers( self, bindings, bindingCount )
+      || ( self-> views = calloc( self-> header-> commandCount, sizeof( *self-> views ) ) ) == NULL )
+   {
+      free( self-> handlers );
+      munmap( image, self-> size );
+      free( self );
+      return NULL;
+   }
+
+   loadTimingEnvironment();
+
+   return &self-> interface;
+}
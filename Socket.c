@@ -0,0 +1,55 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "Socket.h"
+
+
+// Reads exactly `length` bytes; false on error or if the peer hangs up first
+bool readFull( int fd, void *buffer, size_t length )
+{
+char *cursor = buffer;
+ssize_t n;
+
+   while( length > 0 )
+   {
+      if( ( n = read( fd, cursor, length ) ) <= 0 )
+      {
+         if( n < 0 && errno == EINTR )
+         {
+            continue;
+         }
+         return false;
+      }
+      cursor += n;
+      length -= ( size_t ) n;
+   }
+
+   return true;
+}
+
+
+// Writes all `length` bytes without raising SIGPIPE on a closed peer
+bool sendFull( int fd, const void *buffer, size_t length )
+{
+const char *cursor = buffer;
+ssize_t n;
+
+   while( length > 0 )
+   {
+      if( ( n = send( fd, cursor, length, MSG_NOSIGNAL ) ) < 0 )
+      {
+         if( errno == EINTR )
+         {
+            continue;
+         }
+         return false;
+      }
+      cursor += n;
+      length -= ( size_t ) n;
+   }
+
+   return true;
+}
@@ -0,0 +1,540 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "StaticCommand.h"
+#include "Command.h"
+#include "Argument.h"
+#include "Flag.h"
+#include "Help.h"
+#include "Parser.h"
+#include "CLI.h"
+#include "Timing.h"
+
+
+const char * staticArgumentGetName( const Argument_t *self )
+{
+   return self != NULL ? __containerof( self, StaticArgument_t, interface )-> name : NULL;
+}
+
+
+const char * staticArgumentGetDescription( const Argument_t *self )
+{
+   return self != NULL ? __containerof( self, StaticArgument_t, interface )-> description : NULL;
+}
+
+
+bool staticArgumentIsRequired( const Argument_t *self )
+{
+   return self != NULL && __containerof( self, StaticArgument_t, interface )-> required;
+}
+
+
+// Static objects live in the binary's data, not on the heap, so they add nothing to a memory report
+void staticArgumentMeasure( const Argument_t *self, CLIMemoryReport_t *report )
+{
+   ( void ) self;
+   ( void ) report;
+}
+
+
+// Static objects are never freed; deleting one only clears the caller's pointer
+void staticArgumentDelete( Argument_t **selfPtr )
+{
+   if( selfPtr != NULL )
+   {
+      *selfPtr = NULL;
+   }
+}
+
+
+const char * staticFlagGetName( const Flag_t *self )
+{
+   return self != NULL ? __containerof( self, StaticFlag_t, interface )-> name : NULL;
+}
+
+
+const char * staticFlagGetDescription( const Flag_t *self )
+{
+   return self != NULL ? __containerof( self, StaticFlag_t, interface )-> description : NULL;
+}
+
+
+char staticFlagGetShortName( const Flag_t *self )
+{
+   return self != NULL ? __containerof( self, StaticFlag_t, interface )-> shortName : '\0';
+}
+
+
+void staticFlagMeasure( const Flag_t *self, CLIMemoryReport_t *report )
+{
+   ( void ) self;
+   ( void ) report;
+}
+
+
+void staticFlagDelete( Flag_t **selfPtr )
+{
+   if( selfPtr != NULL )
+   {
+      *selfPtr = NULL;
+   }
+}
+
+
+// The tables are read-only, so everything that would change them is refused
+int staticCommandAddSubCommand( Command_t *self, Command_t *subCommand )
+{
+   ( void ) self;
+   ( void ) subCommand;
+
+   return CLI_ERROR_INVALID_ARGUMENT;
+}
+
+
+int staticCommandAddArgument( const Command_t *self, Argument_t *argument )
+{
+   ( void ) self;
+   ( void ) argument;
+
+   return CLI_ERROR_INVALID_ARGUMENT;
+}
+
+
+int staticCommandAddFlag( const Command_t *self, Flag_t *flag )
+{
+   ( void ) self;
+   ( void ) flag;
+
+   return CLI_ERROR_INVALID_ARGUMENT;
+}
+
+
+int staticCommandReserve( const Command_t *self, int subCommands, int arguments, int flags )
+{
+   ( void ) self;
+   ( void ) subCommands;
+   ( void ) arguments;
+   ( void ) flags;
+
+   return CLI_ERROR_INVALID_ARGUMENT;
+}
+
+
+// Already sorted by contract, with nothing to index
+int staticCommandFreeze( Command_t *self, bool compact )
+{
+   ( void ) compact;
+
+   return self != NULL ? CLI_SUCCESS : CLI_ERROR_INVALID_ARGUMENT;
+}
+
+
+int staticCommandParse( Command_t *self, int argc, const char *const argv[] )
+{
+   return executeCommand( self, argc, argv, stdout, stderr );
+}
+
+
+int staticCommandExecute( Command_t *self, int argc, const char *const argv[], FILE *output, FILE *error )
+{
+   return executeCommand( self, argc, argv, output, error );
+}
+
+
+void staticCommandDelete( Command_t **selfPtr )
+{
+   if( selfPtr != NULL )
+   {
+      *selfPtr = NULL;
+   }
+}
+
+
+const char * staticCommandGetName( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> name : NULL;
+}
+
+
+const char * staticCommandGetDescription( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> description : NULL;
+}
+
+
+Argument_t ** staticCommandGetArguments( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> arguments : NULL;
+}
+
+
+int staticCommandGetArgumentCount( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> argumentCount : 0;
+}
+
+
+Flag_t ** staticCommandGetFlags( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> flags : NULL;
+}
+
+
+int staticCommandGetFlagCount( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> flagCount : 0;
+}
+
+
+Command_t ** staticCommandGetSubCommands( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> subCommands : NULL;
+}
+
+
+int staticCommandGetSubCommandCount( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> subCommandCount : 0;
+}
+
+
+// Static levels are sorted, as lookups already rely on, so name order is the list's own
+const char * staticCommandGetSubCommandNameInOrder( const Command_t *self, int position )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL || position < 0 || position >= ( impl = __containerof( self, StaticCommand_t, interface ) )-> subCommandCount )
+   {
+      return NULL;
+   }
+
+   return impl-> subCommands[ position ]-> getName( impl-> subCommands[ position ] );
+}
+
+
+Command_t * staticCommandGetParent( const Command_t *self )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> parent : NULL;
+}
+
+
+int ( *staticCommandGetHandler( const Command_t *self ) )( const CommandContext_t * )
+{
+   return self != NULL ? __containerof( self, StaticCommand_t, interface )-> handler : NULL;
+}
+
+
+// Hand-written tables are not sorted by construction, so the level is checked rather than trusted; help sorts a level
+// that is out of order
+bool staticCommandIsSorted( const Command_t *self )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL )
+   {
+      return true;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   for( int i = 1; i < impl-> subCommandCount; i++ )
+   {
+      if( strcmp( impl-> subCommands[ i - 1 ]-> getName( impl-> subCommands[ i - 1 ] ), impl-> subCommands[ i ]-> getName( impl-> subCommands[ i ] ) ) > 0 )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+
+// Rendered on every call: the tables are read-only, and help is the slow path anyway
+void staticCommandPrintHelp( const Command_t *self, FILE *stream )
+{
+char *text;
+size_t length;
+
+   if( self == NULL || stream == NULL || ( text = formatHelp( self, &length ) ) == NULL )
+   {
+      return;
+   }
+
+   writeHelp( stream, text, length );
+   free( text );
+}
+
+
+void staticCommandForEachSubCommand( const Command_t *self, bool ( *cb )( Command_t *, void * ), void *userData )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   for( int i = 0; i < impl-> subCommandCount; i++ )
+   {
+      if( !cb( impl-> subCommands[ i ], userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// Static levels are always sorted, so the matches are one run found by binary search
+void staticCommandForEachSubCommandWithPrefix( const Command_t *self, const char *prefix, size_t length, bool ( *cb )( Command_t *, void * ), void *userData )
+{
+StaticCommand_t *impl;
+int low = 0, high, middle;
+
+   if( self == NULL || prefix == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   high = impl-> subCommandCount;
+   while( low < high )
+   {
+      middle = low + ( high - low ) / 2;
+      if( strncmp( impl-> subCommands[ middle ]-> getName( impl-> subCommands[ middle ] ), prefix, length ) < 0 )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+
+   for( ; low < impl-> subCommandCount && strncmp( impl-> subCommands[ low ]-> getName( impl-> subCommands[ low ] ), prefix, length ) == 0; low++ )
+   {
+      if( !cb( impl-> subCommands[ low ], userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// Flags keep their declared order, which their handles index, so the few of a command are scanned. Shared with
+// snapshot views, which lay their flags out the same way.
+void staticCommandForEachFlagWithPrefix( const Command_t *self, const char *prefix, size_t length, bool ( *cb )( Flag_t *, void * ), void *userData )
+{
+Flag_t **flags;
+int count;
+
+   if( self == NULL || prefix == NULL || cb == NULL )
+   {
+      return;
+   }
+
+   flags = self-> getFlags( self );
+   count = self-> getFlagCount( self );
+   for( int i = 0; i < count; i++ )
+   {
+      if( strncmp( flags[ i ]-> getName( flags[ i ] ), prefix, length ) == 0 && !cb( flags[ i ], userData ) )
+      {
+         break;
+      }
+   }
+}
+
+
+// Orders a NUL-terminated name against a token of `length` bytes
+static int compareToken( const char *name, const char *token, size_t length )
+{
+int result;
+
+   if( ( result = strncmp( name, token, length ) ) != 0 )
+   {
+      return result;
+   }
+
+   return name[ length ] != '\0';
+}
+
+
+Command_t * staticCommandFindSubCommand( const Command_t *self, const char *name, size_t length )
+{
+StaticCommand_t *impl;
+int low = 0, high, middle;
+
+   if( self == NULL || name == NULL )
+   {
+      return NULL;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   if( impl-> lookupSubCommand != NULL )
+   {
+      return ( low = impl-> lookupSubCommand( name, length ) ) >= 0 ? impl-> subCommands[ low ] : NULL;
+   }
+
+   high = impl-> subCommandCount;
+   while( low < high )
+   {
+      middle = low + ( high - low ) / 2;
+      if( compareToken( impl-> subCommands[ middle ]-> getName( impl-> subCommands[ middle ] ), name, length ) < 0 )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+
+   if( low < impl-> subCommandCount && compareToken( impl-> subCommands[ low ]-> getName( impl-> subCommands[ low ] ), name, length ) == 0 )
+   {
+      return impl-> subCommands[ low ];
+   }
+
+   return NULL;
+}
+
+
+// Flag lists are usually short, so without a lookup function a scan beats any index
+int staticCommandFindFlag( const Command_t *self, const char *name, size_t length )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   if( impl-> lookupFlag != NULL )
+   {
+      return impl-> lookupFlag( name, length );
+   }
+
+   for( int i = 0; i < impl-> flagCount; i++ )
+   {
+      if( compareToken( impl-> flags[ i ]-> getName( impl-> flags[ i ] ), name, length ) == 0 )
+      {
+         return i;
+      }
+   }
+
+   return -1;
+}
+
+
+int staticCommandFindArgument( const Command_t *self, const char *name, size_t length )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL || name == NULL )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   for( int i = 0; i < impl-> argumentCount; i++ )
+   {
+      if( compareToken( impl-> arguments[ i ]-> getName( impl-> arguments[ i ] ), name, length ) == 0 )
+      {
+         return i;
+      }
+   }
+
+   return -1;
+}
+
+
+int staticCommandFindShortFlag( const Command_t *self, char shortName )
+{
+StaticCommand_t *impl;
+
+   if( self == NULL || shortName == '\0' )
+   {
+      return -1;
+   }
+
+   impl = __containerof( self, StaticCommand_t, interface );
+   for( int i = 0; i < impl-> flagCount; i++ )
+   {
+      if( impl-> flags[ i ]-> getShortName( impl-> flags[ i ] ) == shortName )
+      {
+         return i;
+      }
+   }
+
+   return -1;
+}
+
+
+void staticCommandMeasure( const Command_t *self, CLIMemoryReport_t *report )
+{
+   ( void ) self;
+   ( void ) report;
+}
+
+
+// Lookups and completion binary-search the subcommand lists, which would miss commands in a list out of order; the
+// first such list is named on stderr
+int checkStatic( const StaticCommand_t *root )
+{
+int result;
+
+   if( root == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   for( int i = 1; i < root-> subCommandCount; i++ )
+   {
+   const Command_t *previous = root-> subCommands[ i - 1 ], *current = root-> subCommands[ i ];
+
+      if( strcmp( previous-> getName( previous ), current-> getName( current ) ) > 0 )
+      {
+         fprintf( stderr, "Error: Subcommands of '%s' are not sorted by name: '%s' comes before '%s'\n", root-> name, previous-> getName( previous ), current-> getName( current ) );
+         return CLI_ERROR_INVALID_ARGUMENT;
+      }
+   }
+
+   for( int i = 0; i < root-> subCommandCount; i++ )
+   {
+      if( ( result = checkStatic( __containerof( root-> subCommands[ i ], StaticCommand_t, interface ) ) ) != CLI_SUCCESS )
+      {
+         return result;
+      }
+   }
+
+   return CLI_SUCCESS;
+}
+
+
+// Dispatches argv through a static tree on stdout and stderr, as CLI_t parse does for a runtime one. The tree is
+// checked with checkStatic on its first dispatch in the process, so a table out of order fails loudly instead of
+// answering "Unknown command".
+int parseStatic( const StaticCommand_t *root, int argc, char *argv[] )
+{
+static _Atomic( const StaticCommand_t * ) checked;
+int result;
+
+   if( root == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   if( atomic_load_explicit( &checked, memory_order_acquire ) != root )
+   {
+      if( ( result = checkStatic( root ) ) != CLI_SUCCESS )
+      {
+         return result;
+      }
+      atomic_store_explicit( &checked, root, memory_order_release );
+   }
+
+   loadTimingEnvironment();
+   return executeCommand( ( Command_t * )( uintptr_t ) &root-> interface, argc, ( const char *const * ) argv, stdout, stderr );
+}
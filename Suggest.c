@@ -0,0 +1,331 @@
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "Suggest.h"
+#include "Command.h"
+#include "Flag.h"
+
+
+// The longest token edit distances are computed for: one machine word of pattern bits
+#define SUGGEST_MAX_LENGTH   64
+
+
+typedef struct
+{
+   // Bit i of peq[ c ] is set where the token has byte c at position i
+   uint64_t peq[ 256 ];
+   uint64_t last;
+   const char *token;
+   size_t length;
+   // The largest distance still of interest: the limit for the token's length until a name is found, then that name's
+   int bound;
+   int count;
+   const char **names;
+   int capacity;
+} Search;
+
+
+// The distance computation's state after some bytes of a name: the vertical deltas of the current column, as in
+// boundedDistance, the distance to the whole token so far and the column's smallest value
+typedef struct
+{
+   uint64_t pv;
+   uint64_t mv;
+   uint64_t d0;
+   uint64_t previous;
+   int score;
+   int minimum;
+} Column;
+
+
+// Distance allowed for a token of this length: short ones would otherwise resemble everything
+static int boundFor( size_t length )
+{
+   return length <= 4 ? 1 : length <= 8 ? 2 : 3;
+}
+
+
+static void startColumn( const Search *search, Column *column )
+{
+   column-> pv = ~( uint64_t ) 0;
+   column-> mv = 0;
+   column-> d0 = 0;
+   column-> previous = 0;
+   column-> score = ( int ) search-> length;
+   column-> minimum = 0;
+}
+
+
+// Advances the column by one byte of text. Edit distance between the token and a text, counting an adjacent
+// transposition as one edit as well as insertions, deletions and substitutions, is computed a column at a time with
+// the token's rows as the bits of one word (Myers' algorithm, in Hyyrö's formulation for the full distance with
+// transpositions), so each byte costs a few word operations.
+static void stepColumn( const Search *search, Column *column, unsigned char byte )
+{
+uint64_t eq = search-> peq[ byte ], ph, mh;
+
+   column-> d0 = ( ( ( eq & column-> pv ) + column-> pv ) ^ column-> pv ) | eq | column-> mv | ( ( ( ~column-> d0 & eq ) << 1 ) & column-> previous );
+   ph = column-> mv | ~( column-> d0 | column-> pv );
+   mh = column-> d0 & column-> pv;
+
+   if( ph & search-> last )
+   {
+      column-> score++;
+   }
+   else if( mh & search-> last )
+   {
+      column-> score--;
+   }
+
+   // The first row is the distance from the empty prefix of the token, which grows by one per byte of text
+   ph = ( ph << 1 ) | 1;
+   mh <<= 1;
+   column-> pv = mh | ~( column-> d0 | ph );
+   column-> mv = ph & column-> d0;
+   column-> previous = eq;
+}
+
+
+// The smallest value in the column after `depth` bytes, summing its vertical deltas down from the first row
+static int columnMinimum( const Search *search, const Column *column, size_t depth )
+{
+int value = ( int ) depth, minimum = value;
+
+   for( size_t i = 0; i < search-> length; i++ )
+   {
+      value += ( int )( ( column-> pv >> i ) & 1 ) - ( int )( ( column-> mv >> i ) & 1 );
+      minimum = value < minimum ? value : minimum;
+   }
+
+   return minimum;
+}
+
+
+// Distance between the token and `text`. Stops once the distance must exceed the bound: the score moves by at most one
+// per byte.
+static int boundedDistance( const Search *search, const char *text, size_t length )
+{
+Column column;
+
+   startColumn( search, &column );
+   for( size_t j = 0; j < length; j++ )
+   {
+      stepColumn( search, &column, ( unsigned char ) text[ j ] );
+      if( column.score - ( int )( length - j - 1 ) > search-> bound )
+      {
+         return search-> bound + 1;
+      }
+   }
+
+   return column.score;
+}
+
+
+// Keeps a name at the smallest distance seen so far, in the order they are found. Each closer name lowers the bound,
+// so the rest of the search is filtered and cut off ever sooner.
+static void accept( Search *search, const char *name, int distance )
+{
+   if( distance > search-> bound )
+   {
+      return;
+   }
+
+   if( distance < search-> bound )
+   {
+      search-> bound = distance;
+      search-> count = 0;
+   }
+   if( search-> count < search-> capacity )
+   {
+      search-> names[ search-> count++ ] = name;
+   }
+}
+
+
+static void consider( Search *search, const char *name )
+{
+size_t length = strlen( name );
+
+   // Lengths further apart than the bound cannot be within it, which rules out most names without a pass over them
+   if( ( length > search-> length ? length - search-> length : search-> length - length ) <= ( size_t ) search-> bound )
+   {
+      accept( search, name, boundedDistance( search, name, length ) );
+   }
+}
+
+
+// The end of the run in [low, high) whose byte at `depth` is at most `byte`, the level being in name order there
+static int runEnd( const Command_t *command, int low, int high, size_t depth, unsigned char byte )
+{
+int middle;
+
+   while( low < high )
+   {
+      middle = low + ( high - low ) / 2;
+      if( ( unsigned char ) command-> getSubCommandNameInOrder( command, middle )[ depth ] > byte )
+      {
+         high = middle;
+      }
+      else
+      {
+         low = middle + 1;
+      }
+   }
+
+   return low;
+}
+
+
+static void walkLevel( Search *, const Command_t *, int, int, size_t, const Column *, unsigned char );
+
+
+// Follows one byte from the column, unless no name continuing with it can come within the bound: a cell is at least
+// the smaller of the previous column's minimum and the one before's plus one (a transposition reaches back two
+// columns), and that floor never falls as the names grow
+static void walkRun( Search *search, const Command_t *command, int low, int high, size_t depth, const Column *column, unsigned char byte )
+{
+Column next = *column;
+
+   stepColumn( search, &next, byte );
+   next.minimum = columnMinimum( search, &next, depth + 1 );
+   if( ( next.minimum < column-> minimum + 1 ? next.minimum : column-> minimum + 1 ) <= search-> bound )
+   {
+      walkLevel( search, command, low, high, depth + 1, &next, depth + 1 < search-> length ? ( unsigned char ) search-> token[ depth + 1 ] : 0 );
+   }
+}
+
+
+// Walks a level in name order as a trie. Positions [low, high) share their first `depth` bytes, which left the
+// distance computation at `column`, and each next byte's run of names is found by binary search. The run continuing
+// the token as typed goes first, since it most likely holds the closest name and so lowers the bound soonest; runs
+// that cannot come within it are left out whole, so a large level with a common prefix is mostly never looked at.
+static void walkLevel( Search *search, const Command_t *command, int low, int high, size_t depth, const Column *column, unsigned char likely )
+{
+const char *name;
+int end, likelyLow = high, likelyHigh = high;
+unsigned char byte;
+
+   // Names no longer than the prefix sort first, and are the prefix itself
+   for( ; low < high && ( name = command-> getSubCommandNameInOrder( command, low ) )[ depth ] == '\0'; low++ )
+   {
+      accept( search, name, column-> score );
+   }
+
+   if( likely != '\0' && low < high )
+   {
+      likelyLow = runEnd( command, low, high, depth, ( unsigned char )( likely - 1 ) );
+      if( ( likelyHigh = runEnd( command, likelyLow, high, depth, likely ) ) > likelyLow )
+      {
+         walkRun( search, command, likelyLow, likelyHigh, depth, column, likely );
+      }
+   }
+
+   while( low < high )
+   {
+      if( low == likelyLow && likelyHigh > likelyLow )
+      {
+         low = likelyHigh;
+         continue;
+      }
+
+      byte = ( unsigned char ) command-> getSubCommandNameInOrder( command, low )[ depth ];
+      end = runEnd( command, low + 1, high, depth, byte );
+      walkRun( search, command, low, end, depth, column, byte );
+      low = end;
+   }
+}
+
+
+// The few names kept, found out of order by the walk, are listed in name order
+static void sortNames( const char *names[], int count )
+{
+const char *name;
+int j;
+
+   for( int i = 1; i < count; i++ )
+   {
+      for( name = names[ i ], j = i; j > 0 && strcmp( names[ j - 1 ], name ) > 0; j-- )
+      {
+         names[ j ] = names[ j - 1 ];
+      }
+      names[ j ] = name;
+   }
+}
+
+
+static bool visitCommand( Command_t *command, void *search )
+{
+   consider( search, command-> getName( command ) );
+   return true;
+}
+
+
+// Fills `names` with the subcommands of `command` closest to `token`, in name order, or with its long flags for a
+// token starting with "--" (the names are then given without the dashes). Only names within a small edit distance
+// count, and only those at the smallest distance found; returns how many were stored. The names belong to the tree.
+int findSuggestions( const Command_t *command, const char *token, const char *names[], int capacity )
+{
+Search search;
+Column column;
+Flag_t **flags;
+bool flag;
+int count;
+
+   if( command == NULL || token == NULL || names == NULL || capacity <= 0 )
+   {
+      return 0;
+   }
+
+   // Short flags are single letters: there is nothing to measure
+   if( ( flag = token[ 0 ] == '-' ) && token[ 1 ] != '-' )
+   {
+      return 0;
+   }
+
+   if( flag )
+   {
+      token += 2;
+   }
+
+   if( ( search.length = strlen( token ) ) == 0 || search.length > SUGGEST_MAX_LENGTH )
+   {
+      return 0;
+   }
+
+   memset( search.peq, 0, sizeof( search.peq ) );
+   for( size_t i = 0; i < search.length; i++ )
+   {
+      search.peq[ ( unsigned char ) token[ i ] ] |= ( uint64_t ) 1 << i;
+   }
+   search.last = ( uint64_t ) 1 << ( search.length - 1 );
+   search.token = token;
+   search.bound = boundFor( search.length );
+   search.count = 0;
+   search.names = names;
+   search.capacity = capacity;
+
+   // Levels that cannot be taken in name order are scanned
+   if( !flag )
+   {
+      if( ( count = command-> getSubCommandCount( command ) ) > 0 && command-> getSubCommandNameInOrder( command, 0 ) != NULL )
+      {
+         startColumn( &search, &column );
+         walkLevel( &search, command, 0, count, 0, &column, ( unsigned char ) token[ 0 ] );
+         sortNames( search.names, search.count );
+      }
+      else
+      {
+         command-> forEachSubCommand( command, visitCommand, &search );
+      }
+      return search.count;
+   }
+
+   flags = command-> getFlags( command );
+   count = command-> getFlagCount( command );
+   for( int i = 0; i < count; i++ )
+   {
+      consider( &search, flags[ i ]-> getName( flags[ i ] ) );
+   }
+
+   return search.count;
+}
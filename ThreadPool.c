@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "ThreadPool.h"
+#include "CLI.h"
+
+
+// The part of the index space a worker still has to run. The owner takes from the front, thieves split off the back.
+typedef struct
+{
+   pthread_mutex_t lock;
+   size_t begin;
+   size_t end;
+} Range;
+
+
+typedef struct
+{
+   Range *ranges;
+   void ( *job )( void *, int, size_t );
+   void *userData;
+   int workerCount;
+} Run;
+
+
+typedef struct
+{
+   Run *run;
+   int worker;
+} Worker;
+
+
+typedef struct
+{
+   ThreadPool_t interface;
+   int workerCount;
+} Implementation;
+
+
+static bool takeOwn( Range *range, size_t *index )
+{
+bool found = false;
+
+   pthread_mutex_lock( &range-> lock );
+   if( range-> begin < range-> end )
+   {
+      *index = range-> begin++;
+      found = true;
+   }
+   pthread_mutex_unlock( &range-> lock );
+
+   return found;
+}
+
+
+// Moves the back half of some other worker's remaining range into our own; false once every range is empty
+static bool steal( Run *run, int thief )
+{
+Range *own = &run-> ranges[ thief ];
+
+   for( int i = 1; i < run-> workerCount; i++ )
+   {
+   Range *victim = &run-> ranges[ ( thief + i ) % run-> workerCount ];
+   size_t begin, end;
+
+      pthread_mutex_lock( &victim-> lock );
+      end = victim-> end;
+      begin = end - ( end - victim-> begin + 1 ) / 2;
+      victim-> end = begin;
+      pthread_mutex_unlock( &victim-> lock );
+
+      if( begin < end )
+      {
+         pthread_mutex_lock( &own-> lock );
+         own-> begin = begin;
+         own-> end = end;
+         pthread_mutex_unlock( &own-> lock );
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+static void * work( void *arg )
+{
+Worker *worker = arg;
+Run *run = worker-> run;
+size_t index;
+
+   do
+   {
+      while( takeOwn( &run-> ranges[ worker-> worker ], &index ) )
+      {
+         run-> job( run-> userData, worker-> worker, index );
+      }
+   }
+   while( steal( run, worker-> worker ) );
+
+   return NULL;
+}
+
+
+// Calls job( userData, worker, index ) once for every index below count and returns when all calls have finished.
+// Each worker starts on an equal contiguous slice and steals half of a busier worker's remainder when it runs dry.
+static int run( const ThreadPool_t *self, size_t count, void ( *job )( void *, int, size_t ), void *userData )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+Run state;
+Worker *workers;
+pthread_t *threads;
+int started = 1;
+
+   if( job == NULL )
+   {
+      return CLI_ERROR_INVALID_ARGUMENT;
+   }
+
+   state.job = job;
+   state.userData = userData;
+   state.workerCount = impl-> workerCount;
+   state.ranges = calloc( ( size_t ) impl-> workerCount, sizeof( Range ) );
+   workers = calloc( ( size_t ) impl-> workerCount, sizeof( Worker ) );
+   threads = calloc( ( size_t ) impl-> workerCount, sizeof( pthread_t ) );
+   if( state.ranges == NULL || workers == NULL || threads == NULL )
+   {
+      free( state.ranges );
+      free( workers );
+      free( threads );
+      return CLI_ERROR_MEMORY;
+   }
+
+   for( int i = 0; i < impl-> workerCount; i++ )
+   {
+      pthread_mutex_init( &state.ranges[ i ].lock, NULL );
+      state.ranges[ i ].begin = count * ( size_t ) i / ( size_t ) impl-> workerCount;
+      state.ranges[ i ].end = count * ( size_t )( i + 1 ) / ( size_t ) impl-> workerCount;
+      workers[ i ].run = &state;
+      workers[ i ].worker = i;
+   }
+
+   // The calling thread is worker 0; if a thread cannot be started, the others steal its slice
+   for( ; started < impl-> workerCount; started++ )
+   {
+      if( pthread_create( &threads[ started ], NULL, work, &workers[ started ] ) != 0 )
+      {
+         break;
+      }
+   }
+   work( &workers[ 0 ] );
+   for( int i = 1; i < started; i++ )
+   {
+      pthread_join( threads[ i ], NULL );
+   }
+
+   for( int i = 0; i < impl-> workerCount; i++ )
+   {
+      pthread_mutex_destroy( &state.ranges[ i ].lock );
+   }
+   free( state.ranges );
+   free( workers );
+   free( threads );
+
+   return CLI_SUCCESS;
+}
+
+
+static int getWorkerCount( const ThreadPool_t *self )
+{
+Implementation *impl;
+
+   if( self == NULL )
+   {
+      return 0;
+   }
+
+   impl = __containerof( self, Implementation, interface );
+   return impl-> workerCount;
+}
+
+
+static void delete( ThreadPool_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   free( impl );
+   *selfPtr = NULL;
+}
+
+
+ThreadPool_t * newThreadPool( int workerCount )
+{
+Implementation *self;
+
+   if( workerCount < 1 )
+   {
+      return NULL;
+   }
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   self-> workerCount = workerCount;
+   self-> interface.run = run;
+   self-> interface.getWorkerCount = getWorkerCount;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
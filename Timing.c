@@ -0,0 +1,543 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "Timing.h"
+
+
+#define TIMING_BUCKETS            256
+#define TIMING_INITIAL_CAPACITY   64
+#define TIMING_PATH_LENGTH        512
+
+
+typedef struct
+{
+   uint64_t count;
+   uint64_t total;
+   uint64_t max;
+   uint64_t buckets[ TIMING_BUCKETS ];
+} Histogram;
+
+
+// Commands are keyed by their path rather than their address, so the figures outlive the tree and dispatches of the
+// same command through different trees add up
+typedef struct
+{
+   char *path;
+   uint32_t hash;
+   Histogram *phases[ TIMING_PHASE_COUNT ];
+} Entry;
+
+
+// Entries by path, in open addressing
+typedef struct
+{
+   Entry **entries;
+   size_t capacity;
+   size_t count;
+} Table;
+
+
+// The figures of one thread. Dispatch takes only its own thread's lock, so workers never wait on each other, and
+// dumpTiming merges the shards. A shard is handed on when its thread exits, which keeps both the figures and the
+// number of shards, bounded by the most threads ever recording at once.
+typedef struct Shard
+{
+   pthread_mutex_t lock;
+   Table table;
+   bool inUse;
+   struct Shard *next;
+} Shard;
+
+
+static const char *const phaseNames[ TIMING_PHASE_COUNT ] = { "registration", "resolve", "context", "arguments", "handler", "help", "total" };
+
+static atomic_bool enabled;
+static pthread_once_t environmentOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t shardsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t shardKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t shardKey;
+static Shard *shards;
+static char *exitPath;
+
+
+// Log-linear buckets: exact below 4 ns, then four per power of two, so a percentile is within an eighth of the truth
+static int bucketOf( uint64_t value )
+{
+int exponent;
+
+   if( value < 4 )
+   {
+      return ( int ) value;
+   }
+
+   exponent = 63 - __builtin_clzll( value );
+
+   return ( exponent - 1 ) * 4 + ( int )( ( value >> ( exponent - 2 ) ) & 3 );
+}
+
+
+static uint64_t bucketLimit( int bucket )
+{
+int exponent = bucket / 4 + 1;
+
+   if( bucket < 4 )
+   {
+      return ( uint64_t ) bucket;
+   }
+
+   return ( ( uint64_t )( 4 + bucket % 4 ) << ( exponent - 2 ) ) + ( ( uint64_t ) 1 << ( exponent - 2 ) ) - 1;
+}
+
+
+static uint64_t percentile( const Histogram *histogram, double fraction )
+{
+uint64_t rank = ( uint64_t )( fraction * ( double ) histogram-> count + 0.999999 ), seen = 0;
+
+   for( int b = 0; b < TIMING_BUCKETS; b++ )
+   {
+      if( ( seen += histogram-> buckets[ b ] ) >= rank && seen > 0 )
+      {
+         return bucketLimit( b ) < histogram-> max ? bucketLimit( b ) : histogram-> max;
+      }
+   }
+
+   return histogram-> max;
+}
+
+
+static uint32_t hashPath( const char *path )
+{
+uint32_t hash = 2166136261u;
+
+   for( ; *path != '\0'; path++ )
+   {
+      hash ^= ( unsigned char ) *path;
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+// Writes the names from the root down to the command at the end of the buffer; a path too long for it loses its head
+static const char * formatPath( const Command_t *command, char *buffer, size_t size )
+{
+char *cursor = buffer + size - 1;
+
+   *cursor = '\0';
+   for( const Command_t *cmd = command; cmd != NULL; cmd = cmd-> getParent( cmd ) )
+   {
+   const char *name = cmd-> getName( cmd );
+   size_t length = strlen( name );
+
+      if( ( size_t )( cursor - buffer ) < length + 1 )
+      {
+         break;
+      }
+      if( cmd != command )
+      {
+         *--cursor = ' ';
+      }
+      cursor -= length;
+      memcpy( cursor, name, length );
+   }
+
+   return cursor;
+}
+
+
+static Entry ** probe( Entry **table, size_t size, const char *path, uint32_t hash )
+{
+size_t i = hash & ( size - 1 );
+
+   while( table[ i ] != NULL && ( table[ i ]-> hash != hash || strcmp( table[ i ]-> path, path ) != 0 ) )
+   {
+      i = ( i + 1 ) & ( size - 1 );
+   }
+
+   return &table[ i ];
+}
+
+
+// Called with the lock of the table's shard held
+static Entry * findEntry( Table *table, const char *path )
+{
+uint32_t hash = hashPath( path );
+Entry **slot, **grown;
+size_t size;
+
+   if( ( table-> count + 1 ) * 2 > table-> capacity )
+   {
+      size = table-> capacity != 0 ? table-> capacity * 2 : TIMING_INITIAL_CAPACITY;
+      if( ( grown = calloc( size, sizeof( Entry * ) ) ) == NULL )
+      {
+         return NULL;
+      }
+      for( size_t i = 0; i < table-> capacity; i++ )
+      {
+         if( table-> entries[ i ] != NULL )
+         {
+            *probe( grown, size, table-> entries[ i ]-> path, table-> entries[ i ]-> hash ) = table-> entries[ i ];
+         }
+      }
+      free( table-> entries );
+      table-> entries = grown;
+      table-> capacity = size;
+   }
+
+   if( *( slot = probe( table-> entries, table-> capacity, path, hash ) ) == NULL )
+   {
+      if( ( *slot = calloc( 1, sizeof( Entry ) ) ) == NULL )
+      {
+         return NULL;
+      }
+      if( ( ( *slot )-> path = strdup( path ) ) == NULL )
+      {
+         free( *slot );
+         *slot = NULL;
+         return NULL;
+      }
+      ( *slot )-> hash = hash;
+      table-> count++;
+   }
+
+   return *slot;
+}
+
+
+static void clearTable( Table *table )
+{
+   for( size_t i = 0; i < table-> capacity; i++ )
+   {
+      if( table-> entries[ i ] != NULL )
+      {
+         for( int phase = 0; phase < TIMING_PHASE_COUNT; phase++ )
+         {
+            free( table-> entries[ i ]-> phases[ phase ] );
+         }
+         free( table-> entries[ i ]-> path );
+         free( table-> entries[ i ] );
+      }
+   }
+   free( table-> entries );
+   memset( table, 0, sizeof( Table ) );
+}
+
+
+// Frees nothing: an exiting thread's figures stay for whichever thread takes its shard next
+static void releaseShard( void *shard )
+{
+   pthread_mutex_lock( &shardsLock );
+   ( ( Shard * ) shard )-> inUse = false;
+   pthread_mutex_unlock( &shardsLock );
+}
+
+
+static void makeShardKey( void )
+{
+   pthread_key_create( &shardKey, releaseShard );
+}
+
+
+// The calling thread's shard, taken over from an exited thread or made on its first dispatch
+static Shard * currentShard( void )
+{
+Shard *shard;
+
+   pthread_once( &shardKeyOnce, makeShardKey );
+   if( ( shard = pthread_getspecific( shardKey ) ) != NULL )
+   {
+      return shard;
+   }
+
+   pthread_mutex_lock( &shardsLock );
+   for( shard = shards; shard != NULL && shard-> inUse; shard = shard-> next )
+   {
+   }
+   if( shard == NULL && ( shard = calloc( 1, sizeof( Shard ) ) ) != NULL )
+   {
+      pthread_mutex_init( &shard-> lock, NULL );
+      shard-> next = shards;
+      shards = shard;
+   }
+   if( shard != NULL )
+   {
+      shard-> inUse = true;
+   }
+   pthread_mutex_unlock( &shardsLock );
+
+   if( shard != NULL && pthread_setspecific( shardKey, shard ) != 0 )
+   {
+      releaseShard( shard );
+      return NULL;
+   }
+
+   return shard;
+}
+
+
+// Called with the lock of the entry's shard held
+static void record( Entry *entry, TimingPhase_t phase, uint64_t nanoseconds )
+{
+Histogram *histogram;
+
+   if( entry == NULL || ( entry-> phases[ phase ] == NULL && ( entry-> phases[ phase ] = calloc( 1, sizeof( Histogram ) ) ) == NULL ) )
+   {
+      return;
+   }
+
+   histogram = entry-> phases[ phase ];
+   histogram-> count++;
+   histogram-> total += nanoseconds;
+   histogram-> max = nanoseconds > histogram-> max ? nanoseconds : histogram-> max;
+   histogram-> buckets[ bucketOf( nanoseconds ) ]++;
+}
+
+
+// Adds one shard's entry into the merged figures
+static void mergeEntry( Entry *into, const Entry *from )
+{
+Histogram *histogram;
+
+   for( int phase = 0; phase < TIMING_PHASE_COUNT; phase++ )
+   {
+      if( from-> phases[ phase ] == NULL || ( into-> phases[ phase ] == NULL && ( into-> phases[ phase ] = calloc( 1, sizeof( Histogram ) ) ) == NULL ) )
+      {
+         continue;
+      }
+
+      histogram = into-> phases[ phase ];
+      histogram-> count += from-> phases[ phase ]-> count;
+      histogram-> total += from-> phases[ phase ]-> total;
+      histogram-> max = from-> phases[ phase ]-> max > histogram-> max ? from-> phases[ phase ]-> max : histogram-> max;
+      for( int b = 0; b < TIMING_BUCKETS; b++ )
+      {
+         histogram-> buckets[ b ] += from-> phases[ phase ]-> buckets[ b ];
+      }
+   }
+}
+
+
+static void writeAtExit( void )
+{
+FILE *stream;
+
+   if( exitPath == NULL )
+   {
+      dumpTiming( stderr );
+   }
+   else if( ( stream = fopen( exitPath, "a" ) ) != NULL )
+   {
+      dumpTiming( stream );
+      fclose( stream );
+   }
+}
+
+
+// LIBCLI_TIMING=1 times every dispatch and writes the figures to stderr at exit; any other value but 0 names a file
+// to append them to instead
+static void readEnvironment( void )
+{
+const char *value = getenv( "LIBCLI_TIMING" );
+
+   if( value == NULL || value[ 0 ] == '\0' || strcmp( value, "0" ) == 0 )
+   {
+      return;
+   }
+
+   if( strcmp( value, "1" ) != 0 )
+   {
+      exitPath = strdup( value );
+   }
+   atomic_store( &enabled, true );
+   atexit( writeAtExit );
+}
+
+
+void loadTimingEnvironment( void )
+{
+   pthread_once( &environmentOnce, readEnvironment );
+}
+
+
+bool isTimingEnabled( void )
+{
+   return atomic_load_explicit( &enabled, memory_order_relaxed );
+}
+
+
+void enableTiming( bool enable )
+{
+   atomic_store( &enabled, enable );
+}
+
+
+uint64_t timingNow( void )
+{
+struct timespec ts;
+
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+
+   return ( uint64_t ) ts.tv_sec * 1000000000u + ( uint64_t ) ts.tv_nsec;
+}
+
+
+void startSample( TimingSample_t *sample, const Command_t *command )
+{
+   memset( sample, 0, sizeof( TimingSample_t ) );
+   sample-> command = command;
+   sample-> start = sample-> mark = timingNow();
+}
+
+
+void lapSample( TimingSample_t *sample, TimingPhase_t phase )
+{
+uint64_t now;
+
+   if( sample == NULL )
+   {
+      return;
+   }
+
+   now = timingNow();
+   sample-> phases[ phase ] += now - sample-> mark;
+   sample-> mark = now;
+   sample-> laps |= 1u << phase;
+}
+
+
+// Adds the phases the dispatch went through and its total to the histograms of the command it resolved to
+void recordSample( TimingSample_t *sample )
+{
+char buffer[ TIMING_PATH_LENGTH ];
+const char *path;
+uint64_t total = timingNow() - sample-> start;
+Entry *entry;
+Shard *shard;
+
+   if( ( shard = currentShard() ) == NULL )
+   {
+      return;
+   }
+
+   path = formatPath( sample-> command, buffer, sizeof( buffer ) );
+
+   pthread_mutex_lock( &shard-> lock );
+   if( ( entry = findEntry( &shard-> table, path ) ) != NULL )
+   {
+      for( int phase = 0; phase < TIMING_TOTAL; phase++ )
+      {
+         if( sample-> laps & ( 1u << phase ) )
+         {
+            record( entry, ( TimingPhase_t ) phase, sample-> phases[ phase ] );
+         }
+      }
+      record( entry, TIMING_TOTAL, total );
+   }
+   pthread_mutex_unlock( &shard-> lock );
+}
+
+
+void recordTiming( const Command_t *command, TimingPhase_t phase, uint64_t nanoseconds )
+{
+char buffer[ TIMING_PATH_LENGTH ];
+const char *path;
+Shard *shard;
+
+   if( ( shard = currentShard() ) == NULL )
+   {
+      return;
+   }
+
+   path = formatPath( command, buffer, sizeof( buffer ) );
+   pthread_mutex_lock( &shard-> lock );
+   record( findEntry( &shard-> table, path ), phase, nanoseconds );
+   pthread_mutex_unlock( &shard-> lock );
+}
+
+
+static int compareEntries( const void *a, const void *b )
+{
+   return strcmp( ( *( Entry *const * ) a )-> path, ( *( Entry *const * ) b )-> path );
+}
+
+
+// One line per command and phase, sorted by command path, in microseconds; the shards are merged into a copy first,
+// each under its own lock, so dispatch on other threads goes on meanwhile
+void dumpTiming( FILE *stream )
+{
+Table merged = { NULL, 0, 0 };
+Entry **sorted, *entry;
+size_t n = 0;
+
+   if( stream == NULL )
+   {
+      return;
+   }
+
+   pthread_mutex_lock( &shardsLock );
+   for( Shard *shard = shards; shard != NULL; shard = shard-> next )
+   {
+      pthread_mutex_lock( &shard-> lock );
+      for( size_t i = 0; i < shard-> table.capacity; i++ )
+      {
+         if( shard-> table.entries[ i ] != NULL && ( entry = findEntry( &merged, shard-> table.entries[ i ]-> path ) ) != NULL )
+         {
+            mergeEntry( entry, shard-> table.entries[ i ] );
+         }
+      }
+      pthread_mutex_unlock( &shard-> lock );
+   }
+   pthread_mutex_unlock( &shardsLock );
+
+   if( ( sorted = malloc( sizeof( Entry * ) * ( merged.count != 0 ? merged.count : 1 ) ) ) == NULL )
+   {
+      clearTable( &merged );
+      return;
+   }
+   for( size_t i = 0; i < merged.capacity; i++ )
+   {
+      if( merged.entries[ i ] != NULL )
+      {
+         sorted[ n++ ] = merged.entries[ i ];
+      }
+   }
+   qsort( sorted, n, sizeof( Entry * ), compareEntries );
+
+   fprintf( stream, "%-32s %-12s %10s %10s %10s %10s %10s %10s\n", "command", "phase", "count", "mean(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)" );
+   for( size_t i = 0; i < n; i++ )
+   {
+      for( int phase = 0; phase < TIMING_PHASE_COUNT; phase++ )
+      {
+      const Histogram *histogram = sorted[ i ]-> phases[ phase ];
+
+         if( histogram != NULL )
+         {
+            fprintf( stream, "%-32s %-12s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", sorted[ i ]-> path, phaseNames[ phase ],
+                     ( unsigned long long ) histogram-> count, ( double ) histogram-> total / ( double ) histogram-> count / 1e3,
+                     ( double ) percentile( histogram, 0.50 ) / 1e3, ( double ) percentile( histogram, 0.90 ) / 1e3,
+                     ( double ) percentile( histogram, 0.99 ) / 1e3, ( double ) histogram-> max / 1e3 );
+         }
+      }
+   }
+   fflush( stream );
+
+   free( sorted );
+   clearTable( &merged );
+}
+
+
+void resetTiming( void )
+{
+   pthread_mutex_lock( &shardsLock );
+   for( Shard *shard = shards; shard != NULL; shard = shard-> next )
+   {
+      pthread_mutex_lock( &shard-> lock );
+      clearTable( &shard-> table );
+      pthread_mutex_unlock( &shard-> lock );
+   }
+   pthread_mutex_unlock( &shardsLock );
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Tokenizer.h"
+#include "CLI.h"
+
+
+#define TOKENIZER_INITIAL_CAPACITY   16
+
+
+typedef struct
+{
+   Tokenizer_t interface;
+   const char **argv;
+   int capacity;
+} Implementation;
+
+
+static int append( Implementation *impl, int argc, const char *token )
+{
+const char **tmp;
+
+   // Keep one slot spare for the terminating NULL
+   if( argc + 1 >= impl-> capacity )
+   {
+      if( ( tmp = realloc( impl-> argv, sizeof( char * ) * ( size_t ) impl-> capacity * 2 ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      impl-> argv = tmp;
+      impl-> capacity *= 2;
+   }
+
+   impl-> argv[ argc ] = token;
+
+   return CLI_SUCCESS;
+}
+
+
+// Splits a line in place into argv[ 1 .. argc - 1 ], argv[ 0 ] being the program name. Tokens are separated by
+// blanks; single quotes take everything literally, double quotes and bare backslashes escape the next character.
+// Returns argc, or a negative error code. The vector stays valid until the next call.
+static int tokenize( const Tokenizer_t *self, char *line, const char *const **argvPtr )
+{
+Implementation *impl = __containerof( self, Implementation, interface );
+char *read = line, *write;
+int argc = 1;
+char quote;
+
+   while( *read != '\0' )
+   {
+      read += strspn( read, " \t\r\n" );
+      if( *read == '\0' )
+      {
+         break;
+      }
+
+      if( append( impl, argc, read ) != CLI_SUCCESS )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      argc++;
+
+      // Unquoting only ever shrinks a token, so it can be rewritten where it stands
+      write = read;
+      quote = '\0';
+      while( *read != '\0' && ( quote != '\0' || strchr( " \t\r\n", *read ) == NULL ) )
+      {
+         if( quote == '\0' && ( *read == '\'' || *read == '"' ) )
+         {
+            quote = *read++;
+         }
+         else if( quote != '\0' && *read == quote )
+         {
+            quote = '\0';
+            read++;
+         }
+         else if( quote != '\'' && *read == '\\' && read[ 1 ] != '\0' )
+         {
+            *write++ = read[ 1 ];
+            read += 2;
+         }
+         else
+         {
+            *write++ = *read++;
+         }
+      }
+
+      if( quote != '\0' )
+      {
+         return CLI_ERROR_PARSE_FAILED;
+      }
+
+      if( *read != '\0' )
+      {
+         read++;
+      }
+      *write = '\0';
+   }
+
+   impl-> argv[ argc ] = NULL;
+   *argvPtr = impl-> argv;
+
+   return argc;
+}
+
+
+static void delete( Tokenizer_t **selfPtr )
+{
+Implementation *impl;
+
+   if( selfPtr == NULL || *selfPtr == NULL )
+   {
+      return;
+   }
+
+   impl = __containerof( *selfPtr, Implementation, interface );
+   free( impl-> argv );
+   free( impl );
+   *selfPtr = NULL;
+}
+
+
+Tokenizer_t * newTokenizer( const char *programName )
+{
+Implementation *self;
+
+   if( ( self = calloc( 1, sizeof( Implementation ) ) ) == NULL )
+   {
+      return NULL;
+   }
+
+   if( ( self-> argv = calloc( TOKENIZER_INITIAL_CAPACITY, sizeof( char * ) ) ) == NULL )
+   {
+      free( self );
+      return NULL;
+   }
+
+   self-> capacity = TOKENIZER_INITIAL_CAPACITY;
+   self-> argv[ 0 ] = programName;
+   self-> interface.tokenize = tokenize;
+   self-> interface.delete = delete;
+
+   return &self-> interface;
+}
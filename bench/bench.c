@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CLI.h"
+
+
+#define BENCH_ITERATIONS   200000
+
+
+static const int fanOuts[] = { 10, 100, 1000, 10000, 100000 };
+static const int orderingFanOuts[] = { 10, 1000, 100000 };
+
+
+static double now( void )
+{
+struct timespec ts;
+
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+
+   return ( double ) ts.tv_sec * 1e9 + ( double ) ts.tv_nsec;
+}
+
+
+static int quietHandler( const CommandContext_t *context )
+{
+   ( void ) context;
+
+   return CLI_SUCCESS;
+}
+
+
+static int benchLookup( int fanOut )
+{
+CLI_t *cli;
+char **names;
+char program[] = "bench", group[] = "group";
+char *argv[ 3 ];
+double start, registration, dispatch;
+int i;
+
+   if( ( cli = newCLI( "Lookup benchmark" ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   if( ( names = calloc( ( size_t ) fanOut, sizeof( char * ) ) ) == NULL )
+   {
+      cli-> delete( &cli );
+      return CLI_ERROR_MEMORY;
+   }
+
+   cli-> addCommand( cli, "group", "Generated group", NULL );
+
+   start = now();
+   for( i = 0; i < fanOut; i++ )
+   {
+   char name[ 32 ];
+
+      snprintf( name, sizeof( name ), "command%d", i );
+      if( ( names[ i ] = strdup( name ) ) == NULL )
+      {
+         break;
+      }
+      cli-> addSubCommand( cli, "group", name, "Generated command", quietHandler );
+   }
+   registration = ( now() - start ) / fanOut;
+   if( i < fanOut )
+   {
+      while( i-- > 0 )
+      {
+         free( names[ i ] );
+      }
+      free( names );
+      cli-> delete( &cli );
+      return CLI_ERROR_MEMORY;
+   }
+
+   argv[ 0 ] = program;
+   argv[ 1 ] = group;
+   start = now();
+   for( i = 0; i < BENCH_ITERATIONS; i++ )
+   {
+      argv[ 2 ] = names[ ( i * 7919 ) % fanOut ];
+      cli-> parse( cli, 3, argv );
+   }
+   dispatch = ( now() - start ) / BENCH_ITERATIONS;
+
+   printf( "%-10d %14.1f %14.1f\n", fanOut, registration, dispatch );
+
+   for( i = 0; i < fanOut; i++ )
+   {
+      free( names[ i ] );
+   }
+   free( names );
+   cli-> delete( &cli );
+
+   return CLI_SUCCESS;
+}
+
+
+// Registration in scrambled order, first help render and lookup, for the hash index (as built), a tree frozen with
+// its index rebuilt, and a compact tree (no index, binary search over the frozen order)
+static int benchOrdering( int fanOut, const char *mode, int devNull )
+{
+CLI_t *cli;
+char **names;
+char program[] = "bench", group[] = "group", help[] = "--help";
+char *argv[ 3 ] = { program, group, help };
+double start, registration, helpTime, dispatch;
+bool compact = strcmp( mode, "compact" ) == 0;
+int i, result = CLI_SUCCESS, saved;
+
+   if( ( names = calloc( ( size_t ) fanOut, sizeof( char * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+   for( i = 0; i < fanOut; i++ )
+   {
+   char name[ 32 ];
+
+      snprintf( name, sizeof( name ), "command%d", ( int )( ( ( long ) i * 7919 ) % fanOut ) );
+      if( ( names[ i ] = strdup( name ) ) == NULL )
+      {
+         result = CLI_ERROR_MEMORY;
+         break;
+      }
+   }
+
+   if( result != CLI_SUCCESS || ( cli = newCLI( "Ordering benchmark" ) ) == NULL )
+   {
+      for( i = 0; i < fanOut; i++ )
+      {
+         free( names[ i ] );
+      }
+      free( names );
+      return CLI_ERROR_MEMORY;
+   }
+
+   if( compact )
+   {
+      cli-> freeze( cli, true );
+   }
+   cli-> addCommand( cli, "group", "Generated group", NULL );
+
+   start = now();
+   for( i = 0; i < fanOut && result == CLI_SUCCESS; i++ )
+   {
+      result = cli-> addSubCommand( cli, "group", names[ i ], "Generated command", quietHandler );
+   }
+   if( result == CLI_SUCCESS && strcmp( mode, "hashed" ) != 0 )
+   {
+      result = cli-> freeze( cli, compact );
+   }
+   registration = ( now() - start ) / fanOut;
+
+   if( result == CLI_SUCCESS )
+   {
+      // The first request renders and caches the listing, written to /dev/null in place of the terminal
+      fflush( stderr );
+      saved = dup( STDERR_FILENO );
+      dup2( devNull, STDERR_FILENO );
+      start = now();
+      cli-> parse( cli, 3, argv );
+      helpTime = now() - start;
+      dup2( saved, STDERR_FILENO );
+      close( saved );
+
+      start = now();
+      for( i = 0; i < BENCH_ITERATIONS; i++ )
+      {
+         argv[ 2 ] = names[ ( i * 31 ) % fanOut ];
+         cli-> parse( cli, 3, argv );
+      }
+      dispatch = ( now() - start ) / BENCH_ITERATIONS;
+
+      printf( "%-10d %-8s %14.1f %14.1f %14.1f\n", fanOut, mode, registration, helpTime / 1e3, dispatch );
+   }
+
+   for( i = 0; i < fanOut; i++ )
+   {
+      free( names[ i ] );
+   }
+   free( names );
+   cli-> delete( &cli );
+
+   return result;
+}
+
+
+int main( void )
+{
+static const char *const modes[] = { "hashed", "frozen", "compact" };
+int devNull;
+
+   printf( "%-10s %14s %14s\n", "children", "register (ns)", "dispatch (ns)" );
+   for( size_t i = 0; i < sizeof( fanOuts ) / sizeof( fanOuts[ 0 ] ); i++ )
+   {
+      if( benchLookup( fanOuts[ i ] ) != CLI_SUCCESS )
+      {
+         fputs( "Error: benchmark setup failed\n", stderr );
+         return 1;
+      }
+   }
+
+   if( ( devNull = open( "/dev/null", O_WRONLY ) ) < 0 )
+   {
+      return 1;
+   }
+
+   printf( "\n%-10s %-8s %14s %14s %14s\n", "children", "mode", "register (ns)", "help (us)", "dispatch (ns)" );
+   for( size_t i = 0; i < sizeof( orderingFanOuts ) / sizeof( orderingFanOuts[ 0 ] ); i++ )
+   {
+      for( size_t m = 0; m < sizeof( modes ) / sizeof( modes[ 0 ] ); m++ )
+      {
+         if( benchOrdering( orderingFanOuts[ i ], modes[ m ], devNull ) != CLI_SUCCESS )
+         {
+            fputs( "Error: benchmark setup failed\n", stderr );
+            close( devNull );
+            return 1;
+         }
+      }
+   }
+   close( devNull );
+
+   return 0;
+}
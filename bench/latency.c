@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "CLI.h"
+#include "Server.h"
+
+
+#define LATENCY_COMMANDS       1000
+#define LATENCY_WARM_ROUNDS    2000
+#define LATENCY_COLD_ROUNDS    200
+#define LATENCY_WORKERS        "2"
+
+
+extern char **environ;
+
+
+static double now( void )
+{
+struct timespec ts;
+
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+
+   return ( double ) ts.tv_sec * 1e9 + ( double ) ts.tv_nsec;
+}
+
+
+static int quietHandler( const CommandContext_t *context )
+{
+   ( void ) context;
+
+   return CLI_SUCCESS;
+}
+
+
+static int compareSamples( const void *a, const void *b )
+{
+double x = *( const double * ) a, y = *( const double * ) b;
+
+   return ( x > y ) - ( x < y );
+}
+
+
+static void report( const char *mode, double *samples, int count )
+{
+   qsort( samples, ( size_t ) count, sizeof( double ), compareSamples );
+   printf( "%-10s %8d %12.1f %12.1f\n", mode, count, samples[ count / 2 ] / 1e3, samples[ ( count * 99 ) / 100 ] / 1e3 );
+}
+
+
+// The program under test: builds the full tree every time it starts, then parses its own argv (including --serve)
+static int runCLI( int argc, char *argv[] )
+{
+CLI_t *cli;
+int result;
+
+   if( ( cli = newCLI( "Latency benchmark" ) ) == NULL )
+   {
+      return 1;
+   }
+
+   cli-> addCommand( cli, "group", "Generated group", NULL );
+   for( int i = 0; i < LATENCY_COMMANDS; i++ )
+   {
+   char name[ 32 ];
+
+      snprintf( name, sizeof( name ), "command%d", i );
+      cli-> addSubCommand( cli, "group", name, "Generated command", quietHandler );
+   }
+
+   result = cli-> parse( cli, argc, argv );
+   cli-> delete( &cli );
+
+   return result == CLI_SUCCESS ? 0 : 1;
+}
+
+
+static pid_t spawn( char *const argv[], posix_spawn_file_actions_t *actions )
+{
+pid_t pid;
+
+   return posix_spawn( &pid, argv[ 0 ], actions, NULL, argv, environ ) == 0 ? pid : -1;
+}
+
+
+// Times LATENCY_WARM_ROUNDS requests against the running server, then LATENCY_COLD_ROUNDS fresh processes
+static int measure( char *self, const char *path, double *samples, FILE *sink )
+{
+char name[ 32 ], group[] = "group";
+char *coldArgv[] = { self, group, name, NULL };
+const char *warmArgv[] = { self, group, name };
+posix_spawn_file_actions_t quiet;
+double start;
+pid_t child;
+int result = -1, status;
+
+   // Wait for the listener; the first successful round trip also warms the server up
+   strcpy( name, "command0" );
+   for( int i = 0; i < 500 && clientRequest( path, 3, warmArgv, sink, sink, &result ) != CLI_SUCCESS; i++ )
+   {
+      usleep( 10000 );
+   }
+
+   printf( "%-10s %8s %12s %12s\n", "mode", "runs", "p50 (us)", "p99 (us)" );
+
+   for( int i = 0; i < LATENCY_WARM_ROUNDS; i++ )
+   {
+      snprintf( name, sizeof( name ), "command%d", ( i * 7919 ) % LATENCY_COMMANDS );
+      start = now();
+      if( clientRequest( path, 3, warmArgv, sink, sink, &result ) != CLI_SUCCESS )
+      {
+         fputs( "Error: server request failed\n", stderr );
+         return 1;
+      }
+      samples[ i ] = now() - start;
+   }
+   report( "daemon", samples, LATENCY_WARM_ROUNDS );
+
+   posix_spawn_file_actions_init( &quiet );
+   posix_spawn_file_actions_addopen( &quiet, STDOUT_FILENO, "/dev/null", O_WRONLY, 0 );
+   for( int i = 0; i < LATENCY_COLD_ROUNDS; i++ )
+   {
+      snprintf( name, sizeof( name ), "command%d", ( i * 7919 ) % LATENCY_COMMANDS );
+      start = now();
+      if( ( child = spawn( coldArgv, &quiet ) ) < 0 || waitpid( child, &status, 0 ) < 0 )
+      {
+         fputs( "Error: cold run failed\n", stderr );
+         posix_spawn_file_actions_destroy( &quiet );
+         return 1;
+      }
+      samples[ i ] = now() - start;
+   }
+   posix_spawn_file_actions_destroy( &quiet );
+   report( "cold", samples, LATENCY_COLD_ROUNDS );
+
+   return 0;
+}
+
+
+// Loopback harness: one server process on a private socket, measured against spawning the program per command
+static int runHarness( char *self )
+{
+char path[ 64 ], serve[] = "--serve", workers[] = "--workers", workerCount[] = LATENCY_WORKERS;
+char *serverArgv[] = { self, serve, path, workers, workerCount, NULL };
+double *samples;
+FILE *sink;
+pid_t server;
+int result = 1, status;
+
+   snprintf( path, sizeof( path ), "/tmp/libcli-latency.%ld.sock", ( long ) getpid() );
+   if( ( samples = calloc( LATENCY_WARM_ROUNDS, sizeof( double ) ) ) == NULL || ( sink = fopen( "/dev/null", "w" ) ) == NULL )
+   {
+      free( samples );
+      return 1;
+   }
+
+   if( ( server = spawn( serverArgv, NULL ) ) < 0 )
+   {
+      fputs( "Error: cannot start server\n", stderr );
+   }
+   else
+   {
+      result = measure( self, path, samples, sink );
+      kill( server, SIGTERM );
+      waitpid( server, &status, 0 );
+   }
+
+   fclose( sink );
+   free( samples );
+
+   return result;
+}
+
+
+int main( int argc, char *argv[] )
+{
+   if( argc > 1 )
+   {
+      return runCLI( argc, argv );
+   }
+
+   return runHarness( argv[ 0 ] );
+}
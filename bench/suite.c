@@ -0,0 +1,518 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CLI.h"
+
+
+#define SUITE_PARSE_ITERATIONS   100000
+#define SUITE_HELP_ITERATIONS    200
+#define SUITE_TYPO_ITERATIONS    200
+#define SUITE_LOOKUP_ROUNDS      1000
+#define SUITE_LEAF_SAMPLES       1024
+#define SUITE_MAX_FLAGS          64
+#define SUITE_MAX_ARGUMENTS      16
+#define SUITE_PATH_LENGTH        256
+
+
+// A synthetic tree: depth levels of fanOut children under every command, the leaves dispatching to a handler and
+// each taking the given number of optional arguments and flags
+typedef struct
+{
+   const char *name;
+   int depth;
+   int fanOut;
+   int flags;
+   int arguments;
+} Shape;
+
+
+typedef struct
+{
+   const char *benchmark;
+   const Shape *shape;
+   long nodes;
+   int argc;
+   long iterations;
+   double nanoseconds;
+} Result;
+
+
+static const Shape shapes[] =
+{
+   { "wide", 1, 10, 0, 0 },
+   { "wide", 1, 1000, 0, 0 },
+   { "wide", 1, 100000, 0, 0 },
+   { "bushy", 3, 10, 0, 0 },
+   { "bushy", 5, 10, 0, 0 },
+   { "deep", 10, 2, 0, 0 },
+   { "deep", 16, 2, 0, 0 },
+   { "flags", 1, 10, 4, 0 },
+   { "flags", 1, 10, 16, 0 },
+   { "flags", 1, 10, 64, 0 },
+   { "arguments", 1, 10, 0, 1 },
+   { "arguments", 1, 10, 0, 4 },
+   { "arguments", 1, 10, 0, 16 },
+   { "mixed", 2, 100, 8, 4 }
+};
+
+
+static char *flagNames[ SUITE_MAX_FLAGS ], *flagTokens[ SUITE_MAX_FLAGS ], *argumentNames[ SUITE_MAX_ARGUMENTS ];
+static char argumentValue[] = "value";
+static const Shape *lookupShape;
+static double lookupTime;
+static volatile int lookupSink;
+static bool lookupById;
+static bool json, first = true;
+
+
+static double now( void )
+{
+struct timespec ts;
+
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+
+   return ( double ) ts.tv_sec * 1e9 + ( double ) ts.tv_nsec;
+}
+
+
+// Times every argument and flag lookup of the dispatched leaf when a lookup benchmark is running
+static int leafHandler( const CommandContext_t *context )
+{
+double start;
+int found = 0;
+
+   if( lookupShape == NULL )
+   {
+      return CLI_SUCCESS;
+   }
+
+   start = now();
+   for( int r = 0; r < SUITE_LOOKUP_ROUNDS; r++ )
+   {
+      // Arguments and flags are registered in order, so each one's handle is its number
+      for( int a = 0; a < lookupShape-> arguments; a++ )
+      {
+         found += ( lookupById ? context-> getArgumentById( context, a ) : context-> getArgument( context, argumentNames[ a ] ) ) != NULL;
+      }
+      for( int f = 0; f < lookupShape-> flags; f++ )
+      {
+         found += lookupById ? context-> getFlagById( context, f ) : context-> getFlag( context, flagNames[ f ] );
+      }
+   }
+   lookupTime += now() - start;
+   lookupSink += found;
+
+   return CLI_SUCCESS;
+}
+
+
+static long nodeCount( const Shape *shape )
+{
+long nodes = 0, level = 1;
+
+   for( int d = 0; d < shape-> depth; d++ )
+   {
+      level *= shape-> fanOut;
+      nodes += level;
+   }
+
+   return nodes;
+}
+
+
+static long leafCount( const Shape *shape )
+{
+long leaves = 1;
+
+   for( int d = 0; d < shape-> depth; d++ )
+   {
+      leaves *= shape-> fanOut;
+   }
+
+   return leaves;
+}
+
+
+// Writes the names leading to the index-th command of a level, most significant digit first
+static void fillPath( const Shape *shape, char **names, long index, int digits, char **path )
+{
+   for( int d = digits - 1; d >= 0; d-- )
+   {
+      path[ d ] = names[ index % shape-> fanOut ];
+      index /= shape-> fanOut;
+   }
+}
+
+
+static void joinPath( char *const *path, int digits, char *buffer, size_t size )
+{
+size_t length = 0;
+
+   buffer[ 0 ] = '\0';
+   for( int d = 0; d < digits && length < size; d++ )
+   {
+      length += ( size_t ) snprintf( buffer + length, size - length, "%s%s", d > 0 ? " " : "", path[ d ] );
+   }
+}
+
+
+static int generate( const CLI_t *cli, const Shape *shape, char **names )
+{
+char *path[ SUITE_PATH_LENGTH / 2 ];
+char parent[ SUITE_PATH_LENGTH ], leaf[ SUITE_PATH_LENGTH ];
+long parents = 1;
+int result = CLI_SUCCESS;
+
+   for( int level = 1; level <= shape-> depth && result == CLI_SUCCESS; level++ )
+   {
+   bool leaves = level == shape-> depth;
+
+      for( long p = 0; p < parents && result == CLI_SUCCESS; p++ )
+      {
+         fillPath( shape, names, p, level - 1, path );
+         joinPath( path, level - 1, parent, sizeof( parent ) );
+
+         for( int c = 0; c < shape-> fanOut && result == CLI_SUCCESS; c++ )
+         {
+            if( level == 1 )
+            {
+               result = cli-> addCommand( cli, names[ c ], "Generated command", leaves ? leafHandler : NULL );
+            }
+            else
+            {
+               result = cli-> addSubCommand( cli, parent, names[ c ], "Generated command", leaves ? leafHandler : NULL );
+            }
+
+            if( leaves && result == CLI_SUCCESS )
+            {
+               path[ level - 1 ] = names[ c ];
+               joinPath( path, level, leaf, sizeof( leaf ) );
+               for( int a = 0; a < shape-> arguments && result == CLI_SUCCESS; a++ )
+               {
+                  result = cli-> addArgument( cli, leaf, argumentNames[ a ], "Generated argument", false );
+               }
+               for( int f = 0; f < shape-> flags && result == CLI_SUCCESS; f++ )
+               {
+                  result = cli-> addFlag( cli, leaf, flagNames[ f ], f < 26 ? ( char )( 'a' + f ) : '\0', "Generated flag" );
+               }
+            }
+         }
+      }
+      parents *= shape-> fanOut;
+   }
+
+   return result;
+}
+
+
+static void report( const Result *result )
+{
+   if( json )
+   {
+      printf( "%s\n  { \"benchmark\": \"%s\", \"shape\": \"%s\", \"nodes\": %ld, \"depth\": %d, \"fanout\": %d, \"flags\": %d, \"arguments\": %d, \"argc\": %d, \"iterations\": %ld, \"ns_per_op\": %.1f }",
+              first ? "[" : ",", result-> benchmark, result-> shape-> name, result-> nodes, result-> shape-> depth, result-> shape-> fanOut,
+              result-> shape-> flags, result-> shape-> arguments, result-> argc, result-> iterations, result-> nanoseconds );
+   }
+   else
+   {
+      if( first )
+      {
+         puts( "benchmark,shape,nodes,depth,fanout,flags,arguments,argc,iterations,ns_per_op" );
+      }
+      printf( "%s,%s,%ld,%d,%d,%d,%d,%d,%ld,%.1f\n", result-> benchmark, result-> shape-> name, result-> nodes, result-> shape-> depth,
+              result-> shape-> fanOut, result-> shape-> flags, result-> shape-> arguments, result-> argc, result-> iterations, result-> nanoseconds );
+   }
+   first = false;
+   fflush( stdout );
+}
+
+
+// Root help, first render then cached, written to /dev/null in place of the terminal
+static void benchHelp( const CLI_t *cli, const Shape *shape, long nodes, int devNull )
+{
+char program[] = "suite", help[] = "--help";
+char *argv[] = { program, help };
+Result result = { "help_cold", shape, nodes, 2, 1, 0 };
+double start;
+int saved;
+
+   fflush( stderr );
+   saved = dup( STDERR_FILENO );
+   dup2( devNull, STDERR_FILENO );
+
+   start = now();
+   cli-> parse( cli, 2, argv );
+   result.nanoseconds = now() - start;
+   report( &result );
+
+   result.benchmark = "help_warm";
+   result.iterations = SUITE_HELP_ITERATIONS;
+   start = now();
+   for( int i = 0; i < SUITE_HELP_ITERATIONS; i++ )
+   {
+      cli-> parse( cli, 2, argv );
+   }
+   result.nanoseconds = ( now() - start ) / SUITE_HELP_ITERATIONS;
+   report( &result );
+
+   dup2( saved, STDERR_FILENO );
+   close( saved );
+}
+
+
+// A mistyped first-level command, one letter dropped, answered with the closest names instead of the help
+static void benchTypo( const CLI_t *cli, const Shape *shape, char **names, long nodes, int devNull )
+{
+char program[] = "suite", typo[ 32 ];
+char *argv[] = { program, typo };
+Result result = { "typo", shape, nodes, 2, SUITE_TYPO_ITERATIONS, 0 };
+const char *name = names[ shape-> fanOut / 2 ];
+double start;
+int saved;
+
+   snprintf( typo, sizeof( typo ), "%c%s", name[ 0 ], name + 2 );
+   fflush( stderr );
+   saved = dup( STDERR_FILENO );
+   dup2( devNull, STDERR_FILENO );
+
+   start = now();
+   for( int i = 0; i < SUITE_TYPO_ITERATIONS; i++ )
+   {
+      cli-> parse( cli, 2, argv );
+   }
+   result.nanoseconds = ( now() - start ) / SUITE_TYPO_ITERATIONS;
+   report( &result );
+
+   dup2( saved, STDERR_FILENO );
+   close( saved );
+}
+
+
+// Dispatch to sampled leaves with every argument and long flag given, then the lookups made from the handler
+static int benchParse( const CLI_t *cli, const Shape *shape, char **names, long nodes )
+{
+char program[] = "suite";
+long leaves = leafCount( shape ), samples = leaves < SUITE_LEAF_SAMPLES ? leaves : SUITE_LEAF_SAMPLES;
+int argc = 1 + shape-> depth + shape-> arguments + shape-> flags;
+char **argvs;
+Result result = { "parse", shape, nodes, argc, SUITE_PARSE_ITERATIONS, 0 };
+double start;
+
+   if( ( argvs = calloc( ( size_t )( samples * argc ), sizeof( char * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+
+   for( long s = 0; s < samples; s++ )
+   {
+   char **argv = argvs + s * argc;
+
+      argv[ 0 ] = program;
+      fillPath( shape, names, ( s * 7919 ) % leaves, shape-> depth, argv + 1 );
+      for( int a = 0; a < shape-> arguments; a++ )
+      {
+         argv[ 1 + shape-> depth + a ] = argumentValue;
+      }
+      for( int f = 0; f < shape-> flags; f++ )
+      {
+         argv[ 1 + shape-> depth + shape-> arguments + f ] = flagTokens[ f ];
+      }
+   }
+
+   start = now();
+   for( long i = 0; i < SUITE_PARSE_ITERATIONS; i++ )
+   {
+      cli-> parse( cli, argc, argvs + ( i % samples ) * argc );
+   }
+   result.nanoseconds = ( now() - start ) / SUITE_PARSE_ITERATIONS;
+   report( &result );
+
+   for( int byId = 0; byId < 2 && shape-> arguments + shape-> flags > 0; byId++ )
+   {
+      lookupShape = shape;
+      lookupById = byId != 0;
+      lookupTime = 0;
+      for( long s = 0; s < samples; s++ )
+      {
+         cli-> parse( cli, argc, argvs + s * argc );
+      }
+      lookupShape = NULL;
+
+      result.benchmark = byId != 0 ? "lookup_id" : "lookup";
+      result.iterations = samples * SUITE_LOOKUP_ROUNDS * ( shape-> arguments + shape-> flags );
+      result.nanoseconds = lookupTime / ( double ) result.iterations;
+      report( &result );
+   }
+
+   free( argvs );
+
+   return CLI_SUCCESS;
+}
+
+
+static int benchShape( const Shape *shape, int devNull )
+{
+CLI_t *cli;
+char **names;
+long nodes = nodeCount( shape );
+Result result = { "build", shape, nodes, 0, 1, 0 };
+double start;
+int status;
+
+   if( ( names = calloc( ( size_t ) shape-> fanOut, sizeof( char * ) ) ) == NULL )
+   {
+      return CLI_ERROR_MEMORY;
+   }
+   for( int i = 0; i < shape-> fanOut; i++ )
+   {
+   char name[ 32 ];
+
+      snprintf( name, sizeof( name ), "command%d", i );
+      if( ( names[ i ] = strdup( name ) ) == NULL )
+      {
+         while( i-- > 0 )
+         {
+            free( names[ i ] );
+         }
+         free( names );
+         return CLI_ERROR_MEMORY;
+      }
+   }
+
+   // Construction and registration of the whole tree, per node
+   start = now();
+   if( ( cli = newCLI( "Synthetic tree" ) ) == NULL )
+   {
+      status = CLI_ERROR_MEMORY;
+   }
+   else
+   {
+      status = generate( cli, shape, names );
+   }
+   result.nanoseconds = ( now() - start ) / ( double ) nodes;
+
+   if( status == CLI_SUCCESS )
+   {
+      report( &result );
+      benchHelp( cli, shape, nodes, devNull );
+      benchTypo( cli, shape, names, nodes, devNull );
+      status = benchParse( cli, shape, names, nodes );
+   }
+
+   if( cli != NULL )
+   {
+      result.benchmark = "delete";
+      start = now();
+      cli-> delete( &cli );
+      result.nanoseconds = ( now() - start ) / ( double ) nodes;
+      if( status == CLI_SUCCESS )
+      {
+         report( &result );
+      }
+   }
+
+   for( int i = 0; i < shape-> fanOut; i++ )
+   {
+      free( names[ i ] );
+   }
+   free( names );
+
+   return status;
+}
+
+
+static int makeNames( void )
+{
+char name[ 32 ];
+
+   for( int i = 0; i < SUITE_MAX_FLAGS; i++ )
+   {
+      snprintf( name, sizeof( name ), "--flag%d", i );
+      if( ( flagTokens[ i ] = strdup( name ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+      flagNames[ i ] = flagTokens[ i ] + 2;
+   }
+
+   for( int i = 0; i < SUITE_MAX_ARGUMENTS; i++ )
+   {
+      snprintf( name, sizeof( name ), "argument%d", i );
+      if( ( argumentNames[ i ] = strdup( name ) ) == NULL )
+      {
+         return CLI_ERROR_MEMORY;
+      }
+   }
+
+   return CLI_SUCCESS;
+}
+
+
+static void freeNames( void )
+{
+   for( int i = 0; i < SUITE_MAX_FLAGS; i++ )
+   {
+      free( flagTokens[ i ] );
+   }
+   for( int i = 0; i < SUITE_MAX_ARGUMENTS; i++ )
+   {
+      free( argumentNames[ i ] );
+   }
+}
+
+
+int main( int argc, char *argv[] )
+{
+long maxNodes = 0;
+int option, devNull, status = CLI_SUCCESS;
+
+   while( ( option = getopt( argc, argv, "f:n:" ) ) != -1 )
+   {
+      if( option == 'f' && ( strcmp( optarg, "csv" ) == 0 || strcmp( optarg, "json" ) == 0 ) )
+      {
+         json = strcmp( optarg, "json" ) == 0;
+      }
+      else if( option != 'n' || ( maxNodes = atol( optarg ) ) <= 0 )
+      {
+         fprintf( stderr, "Usage: %s [-f csv|json] [-n MAX_NODES]\n", argv[ 0 ] );
+         return 1;
+      }
+   }
+
+   if( ( devNull = open( "/dev/null", O_WRONLY ) ) < 0 )
+   {
+      return 1;
+   }
+
+   if( makeNames() != CLI_SUCCESS )
+   {
+      status = CLI_ERROR_MEMORY;
+   }
+
+   for( size_t i = 0; i < sizeof( shapes ) / sizeof( shapes[ 0 ] ) && status == CLI_SUCCESS; i++ )
+   {
+      if( maxNodes == 0 || nodeCount( &shapes[ i ] ) <= maxNodes )
+      {
+         status = benchShape( &shapes[ i ], devNull );
+      }
+   }
+
+   if( json && !first )
+   {
+      puts( "\n]" );
+   }
+
+   freeNames();
+   close( devNull );
+
+   if( status != CLI_SUCCESS )
+   {
+      fputs( "Error: benchmark setup failed\n", stderr );
+      return 1;
+   }
+
+   return 0;
+}
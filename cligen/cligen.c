@@ -0,0 +1,910 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include "Tokenizer.h"
+
+
+#define CLIGEN_MAX_SEED_TRIES   ( 1u << 20 )
+
+
+typedef struct
+{
+   char *name;
+   char *description;
+   bool required;
+   int line;
+} ArgumentSpec;
+
+
+typedef struct
+{
+   char *name;
+   char *description;
+   char shortName;
+   int line;
+} FlagSpec;
+
+
+typedef struct Node
+{
+   char *name;
+   char *description;
+   char *handler;
+   char *path;
+   char *identifier;
+   struct Node *parent;
+   struct Node **children;
+   ArgumentSpec *arguments;
+   FlagSpec *flags;
+   int childCount;
+   int argumentCount;
+   int flagCount;
+   int id;
+   int line;
+} Node;
+
+
+// A perfect hash over one set of names: bucket b = hash( key, 0 ) & ( bucketCount - 1 ) and every key of that bucket
+// lands in slot hash( key, seeds[ b ] ) & ( slotCount - 1 ), where no other key does
+typedef struct
+{
+   uint32_t *seeds;
+   int *slots;
+   uint32_t bucketCount;
+   uint32_t slotCount;
+} PerfectHash;
+
+
+// A name the generated header declares and the spec line it comes from, 0 for the ones cligen adds itself
+typedef struct
+{
+   char *identifier;
+   char *declaration;
+   int line;
+} Identifier;
+
+
+static const char *specName;
+static const char *specBaseName;
+static int lineNumber;
+// FNV-1a over the tokens of every declaration, so that comments and spacing leave it unchanged
+static uint64_t treeId = 14695981039346656037u;
+
+
+static void fail( const char *message, const char *detail )
+{
+   fprintf( stderr, "cligen: %s:%d: %s%s%s\n", specName, lineNumber, message, detail != NULL ? ": " : "", detail != NULL ? detail : "" );
+   exit( 1 );
+}
+
+
+static void * xcalloc( size_t count, size_t size )
+{
+void *ptr;
+
+   if( ( ptr = calloc( count != 0 ? count : 1, size ) ) == NULL )
+   {
+      fail( "out of memory", NULL );
+   }
+
+   return ptr;
+}
+
+
+static char * xstrdup( const char *str )
+{
+char *copy;
+
+   if( ( copy = strdup( str ) ) == NULL )
+   {
+      fail( "out of memory", NULL );
+   }
+
+   return copy;
+}
+
+
+static void * xrealloc( void *ptr, size_t size )
+{
+   if( ( ptr = realloc( ptr, size ) ) == NULL )
+   {
+      fail( "out of memory", NULL );
+   }
+
+   return ptr;
+}
+
+
+// Must match the function emitted into the generated source
+static uint32_t hashName( const char *name, size_t length, uint32_t seed )
+{
+uint32_t hash = 2166136261u ^ seed;
+
+   for( size_t i = 0; i < length; i++ )
+   {
+      hash ^= ( unsigned char ) name[ i ];
+      hash *= 16777619u;
+   }
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6bu;
+   hash ^= hash >> 13;
+
+   return hash;
+}
+
+
+static uint32_t powerOfTwo( uint32_t n )
+{
+uint32_t p = 1;
+
+   while( p < n )
+   {
+      p <<= 1;
+   }
+
+   return p;
+}
+
+
+// Places the buckets largest first, trying seeds until all keys of a bucket find free, distinct slots; grows the
+// table and starts over in the unlikely case that some bucket finds no seed
+static PerfectHash buildPerfectHash( const char *const *keys, int count )
+{
+PerfectHash ph;
+int *bucketOf = xcalloc( ( size_t ) count, sizeof( int ) ), *order = xcalloc( ( size_t ) count, sizeof( int ) ), *tried = xcalloc( ( size_t ) count, sizeof( int ) );
+uint32_t slotCount = powerOfTwo( ( uint32_t ) count + ( uint32_t ) count / 4 + 1 );
+
+   for( ;; )
+   {
+   bool placed = true;
+   int *sizes;
+
+      ph.slotCount = slotCount;
+      ph.bucketCount = powerOfTwo( ( uint32_t ) count / 2 + 1 );
+      ph.seeds = xcalloc( ph.bucketCount, sizeof( uint32_t ) );
+      ph.slots = xcalloc( ph.slotCount, sizeof( int ) );
+      sizes = xcalloc( ph.bucketCount, sizeof( int ) );
+      for( uint32_t s = 0; s < ph.slotCount; s++ )
+      {
+         ph.slots[ s ] = -1;
+      }
+
+      for( int i = 0; i < count; i++ )
+      {
+         bucketOf[ i ] = ( int )( hashName( keys[ i ], strlen( keys[ i ] ), 0 ) & ( ph.bucketCount - 1 ) );
+         sizes[ bucketOf[ i ] ]++;
+         order[ i ] = i;
+      }
+
+      // Keys grouped by bucket, fullest bucket first
+      for( int i = 1; i < count; i++ )
+      {
+      int key = order[ i ], j = i;
+
+         while( j > 0 && ( sizes[ bucketOf[ order[ j - 1 ] ] ] < sizes[ bucketOf[ key ] ] || ( sizes[ bucketOf[ order[ j - 1 ] ] ] == sizes[ bucketOf[ key ] ] && bucketOf[ order[ j - 1 ] ] > bucketOf[ key ] ) ) )
+         {
+            order[ j ] = order[ j - 1 ];
+            j--;
+         }
+         order[ j ] = key;
+      }
+
+      for( int start = 0; placed && start < count; )
+      {
+      int bucket = bucketOf[ order[ start ] ], end = start;
+      uint32_t seed;
+
+         while( end < count && bucketOf[ order[ end ] ] == bucket )
+         {
+            end++;
+         }
+
+         for( seed = 1; seed < CLIGEN_MAX_SEED_TRIES; seed++ )
+         {
+         int k;
+
+            for( k = start; k < end; k++ )
+            {
+            uint32_t slot = hashName( keys[ order[ k ] ], strlen( keys[ order[ k ] ] ), seed ) & ( ph.slotCount - 1 );
+
+               if( ph.slots[ slot ] >= 0 )
+               {
+                  break;
+               }
+               ph.slots[ slot ] = order[ k ];
+               tried[ k ] = ( int ) slot;
+            }
+            if( k == end )
+            {
+               break;
+            }
+
+            // Undo the partial placement before the next seed
+            while( k-- > start )
+            {
+               ph.slots[ tried[ k ] ] = -1;
+            }
+         }
+
+         if( seed == CLIGEN_MAX_SEED_TRIES )
+         {
+            placed = false;
+         }
+         ph.seeds[ bucket ] = seed;
+         start = end;
+      }
+
+      free( sizes );
+      if( placed )
+      {
+         break;
+      }
+
+      free( ph.seeds );
+      free( ph.slots );
+      slotCount *= 2;
+   }
+
+   free( bucketOf );
+   free( order );
+   free( tried );
+
+   return ph;
+}
+
+
+static void emitString( FILE *out, const char *str )
+{
+   if( str == NULL )
+   {
+      fputs( "NULL", out );
+      return;
+   }
+
+   fputc( '"', out );
+   for( ; *str != '\0'; str++ )
+   {
+      if( *str == '"' || *str == '\\' )
+      {
+         fprintf( out, "\\%c", *str );
+      }
+      else if( isprint( ( unsigned char ) *str ) )
+      {
+         fputc( *str, out );
+      }
+      else
+      {
+         fprintf( out, "\\%03o", ( unsigned char ) *str );
+      }
+   }
+   fputc( '"', out );
+}
+
+
+static void hashDeclaration( int argc, const char *const *argv )
+{
+   for( int i = 1; i < argc; i++ )
+   {
+      // The terminator is hashed too, so that tokens cannot run into each other
+      for( const char *cursor = argv[ i ]; ; cursor++ )
+      {
+         treeId ^= ( unsigned char ) *cursor;
+         treeId *= 1099511628211u;
+         if( *cursor == '\0' )
+         {
+            break;
+         }
+      }
+   }
+}
+
+
+static char * makeIdentifier( const char *prefix, const char *path )
+{
+size_t length = strlen( prefix ) + strlen( path ) + 2;
+char *identifier = xcalloc( length, 1 ), *cursor;
+
+   snprintf( identifier, length, "%s%s%s", prefix, path[ 0 ] != '\0' ? "_" : "", path );
+   for( cursor = identifier; *cursor != '\0'; cursor++ )
+   {
+      *cursor = isalnum( ( unsigned char ) *cursor ) ? ( char ) toupper( ( unsigned char ) *cursor ) : '_';
+   }
+
+   return identifier;
+}
+
+
+static Node * findPath( Node *root, const char *path )
+{
+Node *node = root;
+const char *cursor = path;
+
+   while( node != NULL && *cursor != '\0' )
+   {
+   size_t length;
+   int i;
+
+      cursor += strspn( cursor, "/" );
+      if( ( length = strcspn( cursor, "/" ) ) == 0 )
+      {
+         break;
+      }
+
+      for( i = 0; i < node-> childCount; i++ )
+      {
+         if( strncmp( node-> children[ i ]-> name, cursor, length ) == 0 && node-> children[ i ]-> name[ length ] == '\0' )
+         {
+            break;
+         }
+      }
+      node = i < node-> childCount ? node-> children[ i ] : NULL;
+      cursor += length;
+   }
+
+   return node;
+}
+
+
+static void addCommand( Node *root, const char *path, const char *description, const char *handler )
+{
+const char *slash = strrchr( path, '/' );
+char *parentPath = xstrdup( path );
+Node *parent, *node;
+
+   parentPath[ slash != NULL ? ( size_t )( slash - path ) : 0 ] = '\0';
+   if( ( parent = findPath( root, parentPath ) ) == NULL )
+   {
+      fail( "parent command not declared", path );
+   }
+   free( parentPath );
+
+   if( findPath( root, path ) != root && findPath( root, path ) != NULL )
+   {
+      fail( "command declared twice", path );
+   }
+
+   node = xcalloc( 1, sizeof( Node ) );
+   node-> name = xstrdup( slash != NULL ? slash + 1 : path );
+   node-> description = xstrdup( description );
+   node-> handler = handler != NULL ? xstrdup( handler ) : NULL;
+   node-> path = xstrdup( path );
+   node-> parent = parent;
+   node-> line = lineNumber;
+   if( node-> name[ 0 ] == '\0' )
+   {
+      fail( "empty command name", path );
+   }
+
+   parent-> children = xrealloc( parent-> children, sizeof( Node * ) * ( size_t )( parent-> childCount + 1 ) );
+   parent-> children[ parent-> childCount++ ] = node;
+}
+
+
+static int compareNodes( const void *a, const void *b )
+{
+   return strcmp( ( *( Node *const * ) a )-> name, ( *( Node *const * ) b )-> name );
+}
+
+
+// Sorts every level by name, as static subcommand lists require, and numbers the commands in preorder
+static void assignIds( Node *node, const char *prefix, int *next, Node **byId )
+{
+   if( node-> childCount > 1 )
+   {
+      qsort( node-> children, ( size_t ) node-> childCount, sizeof( Node * ), compareNodes );
+   }
+   node-> id = ( *next )++;
+   node-> identifier = makeIdentifier( prefix, node-> parent != NULL ? node-> path : "ROOT" );
+   if( byId != NULL )
+   {
+      byId[ node-> id ] = node;
+   }
+
+   for( int i = 0; i < node-> childCount; i++ )
+   {
+      assignIds( node-> children[ i ], prefix, next, byId );
+   }
+}
+
+
+// The handle of one of a command's arguments or flags, `kind` being "ARGUMENT" or "FLAG"
+static char * makeHandle( const Node *node, const char *name, const char *kind )
+{
+char *base = makeIdentifier( node-> identifier, name ), *handle;
+size_t length = strlen( base ) + strlen( kind ) + 2;
+
+   handle = xcalloc( length, 1 );
+   snprintf( handle, length, "%s_%s", base, kind );
+   free( base );
+
+   return handle;
+}
+
+
+static char * describe( const char *kind, const char *name, const char *path )
+{
+size_t length = strlen( kind ) + strlen( name ) + strlen( path ) + 6;
+char *declaration = xcalloc( length, 1 );
+
+   snprintf( declaration, length, path[ 0 ] != '\0' ? "%s %s of %s" : "%s %s", kind, name, path );
+
+   return declaration;
+}
+
+
+static void addIdentifier( Identifier *identifiers, int *count, char *identifier, char *declaration, int line )
+{
+   identifiers[ *count ].identifier = identifier;
+   identifiers[ *count ].declaration = declaration;
+   identifiers[ *count ].line = line;
+   ( *count )++;
+}
+
+
+static int compareIdentifiers( const void *a, const void *b )
+{
+const Identifier *left = a, *right = b;
+int result = strcmp( left-> identifier, right-> identifier );
+
+   return result != 0 ? result : left-> line - right-> line;
+}
+
+
+// Names are folded to upper case and everything but letters and digits to '_', so distinct declarations can meet in
+// one identifier: remote-add and remote_add, a top-level remote_add and remote/add, or a command named like a handle
+// or one of the names cligen adds. Every such clash is reported at the later of the two lines.
+static void checkIdentifiers( Node **byId, int count, const char *prefix, const char *guard )
+{
+Identifier *identifiers;
+char *message;
+size_t length;
+int total = 3, n = 0;
+
+   for( int i = 0; i < count; i++ )
+   {
+      total += 1 + byId[ i ]-> argumentCount + byId[ i ]-> flagCount;
+   }
+   identifiers = xcalloc( ( size_t ) total, sizeof( Identifier ) );
+
+   addIdentifier( identifiers, &n, makeIdentifier( prefix, "COMMAND_COUNT" ), xstrdup( "the command count" ), 0 );
+   addIdentifier( identifiers, &n, makeIdentifier( prefix, "TREE_ID" ), xstrdup( "the tree identifier" ), 0 );
+   addIdentifier( identifiers, &n, xstrdup( guard ), xstrdup( "the header guard" ), 0 );
+   for( int i = 0; i < count; i++ )
+   {
+   const Node *node = byId[ i ];
+
+      addIdentifier( identifiers, &n, xstrdup( node-> identifier ), node-> parent != NULL ? describe( "command", node-> path, "" ) : describe( "program", node-> name, "" ), node-> line );
+      for( int a = 0; a < node-> argumentCount; a++ )
+      {
+         addIdentifier( identifiers, &n, makeHandle( node, node-> arguments[ a ].name, "ARGUMENT" ), describe( "argument", node-> arguments[ a ].name, node-> path ), node-> arguments[ a ].line );
+      }
+      for( int f = 0; f < node-> flagCount; f++ )
+      {
+         addIdentifier( identifiers, &n, makeHandle( node, node-> flags[ f ].name, "FLAG" ), describe( "flag", node-> flags[ f ].name, node-> path ), node-> flags[ f ].line );
+      }
+   }
+
+   qsort( identifiers, ( size_t ) n, sizeof( Identifier ), compareIdentifiers );
+   for( int i = 1; i < n; i++ )
+   {
+      if( strcmp( identifiers[ i - 1 ].identifier, identifiers[ i ].identifier ) == 0 )
+      {
+         length = strlen( identifiers[ i ].identifier ) + strlen( identifiers[ i ].declaration ) + strlen( identifiers[ i - 1 ].declaration ) + 32;
+         message = xcalloc( length, 1 );
+         snprintf( message, length, "%s gives %s, as %s does", identifiers[ i ].declaration, identifiers[ i ].identifier, identifiers[ i - 1 ].declaration );
+         lineNumber = identifiers[ i ].line;
+         fail( "identifier clash", message );
+      }
+   }
+
+   for( int i = 0; i < n; i++ )
+   {
+      free( identifiers[ i ].identifier );
+      free( identifiers[ i ].declaration );
+   }
+   free( identifiers );
+}
+
+
+static void emitLookup( FILE *out, const char *function, const char *const *keys, int count )
+{
+PerfectHash ph = buildPerfectHash( keys, count );
+
+   fprintf( out, "static int %s( const char *name, size_t length )\n{\n", function );
+   fprintf( out, "static const uint32_t seeds[ %u ] = { ", ph.bucketCount );
+   for( uint32_t b = 0; b < ph.bucketCount; b++ )
+   {
+      fprintf( out, "%s%uu", b > 0 ? ", " : "", ph.seeds[ b ] );
+   }
+   fprintf( out, " };\nstatic const char *const keys[ %u ] = { ", ph.slotCount );
+   for( uint32_t s = 0; s < ph.slotCount; s++ )
+   {
+      fputs( s > 0 ? ", " : "", out );
+      emitString( out, ph.slots[ s ] >= 0 ? keys[ ph.slots[ s ] ] : NULL );
+   }
+   fprintf( out, " };\nstatic const int positions[ %u ] = { ", ph.slotCount );
+   for( uint32_t s = 0; s < ph.slotCount; s++ )
+   {
+      fprintf( out, "%s%d", s > 0 ? ", " : "", ph.slots[ s ] );
+   }
+   fprintf( out, " };\nuint32_t slot = hashName( name, length, seeds[ hashName( name, length, 0 ) & %uu ] ) & %uu;\n\n", ph.bucketCount - 1, ph.slotCount - 1 );
+   fputs( "   return keys[ slot ] != NULL && strncmp( keys[ slot ], name, length ) == 0 && keys[ slot ][ length ] == '\\0' ? positions[ slot ] : -1;\n}\n\n\n", out );
+
+   free( ph.seeds );
+   free( ph.slots );
+}
+
+
+static void emitHeader( FILE *out, Node **byId, int count, const char *prefix, const char *guard )
+{
+char *counter = makeIdentifier( prefix, "" );
+
+   fprintf( out, "// Generated by cligen from %s; do not edit.\n\n#ifndef %s\n#define %s\n\n\n#include \"StaticCommand.h\"\n\n\nenum\n{\n", specBaseName, guard, guard );
+   for( int i = 0; i < count; i++ )
+   {
+      fprintf( out, "   %s,\n", byId[ i ]-> identifier );
+   }
+   fprintf( out, "   %s_COMMAND_COUNT\n};\n\n", counter );
+   // Changes whenever the description does, so it can stamp snapshots of the tree
+   fprintf( out, "#define %s_TREE_ID 0x%016llxull\n\n", counter, ( unsigned long long ) treeId );
+   // Argument and flag handles per command, for getArgumentById / getFlagById
+   for( int i = 0; i < count; i++ )
+   {
+      if( byId[ i ]-> argumentCount + byId[ i ]-> flagCount == 0 )
+      {
+         continue;
+      }
+      fputs( "enum\n{\n", out );
+      for( int a = 0; a < byId[ i ]-> argumentCount; a++ )
+      {
+      char *handle = makeHandle( byId[ i ], byId[ i ]-> arguments[ a ].name, "ARGUMENT" );
+
+         fprintf( out, "   %s = %d,\n", handle, a );
+         free( handle );
+      }
+      for( int f = 0; f < byId[ i ]-> flagCount; f++ )
+      {
+      char *handle = makeHandle( byId[ i ], byId[ i ]-> flags[ f ].name, "FLAG" );
+
+         fprintf( out, "   %s = %d,\n", handle, f );
+         free( handle );
+      }
+      fputs( "};\n\n", out );
+   }
+
+   fprintf( out, "extern const StaticCommand_t %sCommands[];\n\n", prefix );
+   fprintf( out, "int %sCommandId( const CommandContext_t * );\n", prefix );
+   fprintf( out, "int %sParse( int, char *[] );\n\n", prefix );
+
+   // Each handler once, however many commands share it
+   for( int i = 0; i < count; i++ )
+   {
+   bool seen = byId[ i ]-> handler == NULL;
+
+      for( int j = 0; !seen && j < i; j++ )
+      {
+         seen = byId[ j ]-> handler != NULL && strcmp( byId[ j ]-> handler, byId[ i ]-> handler ) == 0;
+      }
+      if( !seen )
+      {
+         fprintf( out, "int %s( const CommandContext_t * );\n", byId[ i ]-> handler );
+      }
+   }
+
+   fputs( "\n#endif\n", out );
+   free( counter );
+}
+
+
+static void emitSource( FILE *out, Node **byId, int count, const char *prefix, const char *header )
+{
+   fprintf( out, "// Generated by cligen from %s; do not edit.\n\n#include <string.h>\n#include <stdint.h>\n#include \"StaticCommand.h\"\n#include \"%s\"\n\n\n", specBaseName, header );
+   fputs( "static uint32_t hashName( const char *name, size_t length, uint32_t seed )\n{\nuint32_t hash = 2166136261u ^ seed;\n\n"
+          "   for( size_t i = 0; i < length; i++ )\n   {\n      hash ^= ( unsigned char ) name[ i ];\n      hash *= 16777619u;\n   }\n"
+          "   hash ^= hash >> 16;\n   hash *= 0x85ebca6bu;\n   hash ^= hash >> 13;\n\n   return hash;\n}\n\n\n", out );
+
+   for( int i = 0; i < count; i++ )
+   {
+   Node *node = byId[ i ];
+   const char **keys;
+   char function[ 64 ];
+
+      if( node-> argumentCount > 0 )
+      {
+         fprintf( out, "static const StaticArgument_t arguments%d[] =\n{\n", i );
+         for( int a = 0; a < node-> argumentCount; a++ )
+         {
+            fputs( "   CLI_STATIC_ARGUMENT( ", out );
+            emitString( out, node-> arguments[ a ].name );
+            fputs( ", ", out );
+            emitString( out, node-> arguments[ a ].description );
+            fprintf( out, ", %s ),\n", node-> arguments[ a ].required ? "true" : "false" );
+         }
+         fprintf( out, "};\n\nstatic Argument_t *const argumentList%d[] = { ", i );
+         for( int a = 0; a < node-> argumentCount; a++ )
+         {
+            fprintf( out, "%sCLI_STATIC_REF( arguments%d[ %d ] )", a > 0 ? ", " : "", i, a );
+         }
+         fputs( " };\n\n\n", out );
+      }
+
+      if( node-> flagCount > 0 )
+      {
+         fprintf( out, "static const StaticFlag_t flags%d[] =\n{\n", i );
+         keys = xcalloc( ( size_t ) node-> flagCount, sizeof( char * ) );
+         for( int f = 0; f < node-> flagCount; f++ )
+         {
+            fputs( "   CLI_STATIC_FLAG( ", out );
+            emitString( out, node-> flags[ f ].name );
+            if( node-> flags[ f ].shortName != '\0' )
+            {
+               fprintf( out, ", '%s%c', ", node-> flags[ f ].shortName == '\'' || node-> flags[ f ].shortName == '\\' ? "\\" : "", node-> flags[ f ].shortName );
+            }
+            else
+            {
+               fputs( ", '\\0', ", out );
+            }
+            emitString( out, node-> flags[ f ].description );
+            fputs( " ),\n", out );
+            keys[ f ] = node-> flags[ f ].name;
+         }
+         fprintf( out, "};\n\nstatic Flag_t *const flagList%d[] = { ", i );
+         for( int f = 0; f < node-> flagCount; f++ )
+         {
+            fprintf( out, "%sCLI_STATIC_REF( flags%d[ %d ] )", f > 0 ? ", " : "", i, f );
+         }
+         fputs( " };\n\n\n", out );
+
+         fprintf( out, "// Long flags of %s\n", node-> identifier );
+         snprintf( function, sizeof( function ), "lookupFlag%d", i );
+         emitLookup( out, function, keys, node-> flagCount );
+         free( keys );
+      }
+
+      if( node-> childCount > 0 )
+      {
+         fprintf( out, "static Command_t *const subCommandList%d[] = { ", i );
+         keys = xcalloc( ( size_t ) node-> childCount, sizeof( char * ) );
+         for( int c = 0; c < node-> childCount; c++ )
+         {
+            fprintf( out, "%sCLI_STATIC_REF( %sCommands[ %s ] )", c > 0 ? ", " : "", prefix, node-> children[ c ]-> identifier );
+            keys[ c ] = node-> children[ c ]-> name;
+         }
+         fputs( " };\n\n", out );
+
+         fprintf( out, "// Subcommands of %s\n", node-> identifier );
+         snprintf( function, sizeof( function ), "lookupSubCommand%d", i );
+         emitLookup( out, function, keys, node-> childCount );
+         free( keys );
+      }
+   }
+
+   fprintf( out, "const StaticCommand_t %sCommands[] =\n{\n", prefix );
+   for( int i = 0; i < count; i++ )
+   {
+   Node *node = byId[ i ];
+
+      fputs( "   CLI_STATIC_COMMAND_LOOKUP( ", out );
+      if( node-> parent != NULL )
+      {
+         fprintf( out, "CLI_STATIC_REF( %sCommands[ %s ] ), ", prefix, node-> parent-> identifier );
+      }
+      else
+      {
+         fputs( "NULL, ", out );
+      }
+      emitString( out, node-> name );
+      fputs( ", ", out );
+      emitString( out, node-> description );
+      fprintf( out, ", %s, ", node-> handler != NULL ? node-> handler : "NULL" );
+      if( node-> childCount > 0 )
+      {
+         fprintf( out, "CLI_STATIC_LIST( subCommandList%d ), ", i );
+      }
+      else
+      {
+         fputs( "CLI_STATIC_NONE, ", out );
+      }
+      if( node-> argumentCount > 0 )
+      {
+         fprintf( out, "CLI_STATIC_LIST( argumentList%d ), ", i );
+      }
+      else
+      {
+         fputs( "CLI_STATIC_NONE, ", out );
+      }
+      if( node-> flagCount > 0 )
+      {
+         fprintf( out, "CLI_STATIC_LIST( flagList%d ), ", i );
+      }
+      else
+      {
+         fputs( "CLI_STATIC_NONE, ", out );
+      }
+      if( node-> childCount > 0 )
+      {
+         fprintf( out, "lookupSubCommand%d, ", i );
+      }
+      else
+      {
+         fputs( "NULL, ", out );
+      }
+      if( node-> flagCount > 0 )
+      {
+         fprintf( out, "lookupFlag%d ),\n", i );
+      }
+      else
+      {
+         fputs( "NULL ),\n", out );
+      }
+   }
+   fputs( "};\n\n\n", out );
+
+   fprintf( out, "// The command a handler was dispatched for, as one of the enum values, or -1 for a command outside this table\n"
+                 "int %sCommandId( const CommandContext_t *context )\n{\n"
+                 "uintptr_t offset = ( uintptr_t ) context-> getCommand( context ) - ( uintptr_t ) %sCommands;\n\n"
+                 "   return offset < sizeof( %sCommands ) ? ( int )( offset / sizeof( StaticCommand_t ) ) : -1;\n}\n\n\n", prefix, prefix, prefix );
+   fprintf( out, "int %sParse( int argc, char *argv[] )\n{\n   return parseStatic( &%sCommands[ 0 ], argc, argv );\n}\n", prefix, prefix );
+}
+
+
+static void parseSpec( FILE *in, Node *root, char **prefix )
+{
+Tokenizer_t *tokenizer;
+const char *const *argv;
+char *line = NULL;
+size_t capacity = 0;
+int argc;
+
+   if( ( tokenizer = newTokenizer( "cligen" ) ) == NULL )
+   {
+      fail( "out of memory", NULL );
+   }
+
+   for( lineNumber = 1; getline( &line, &capacity, in ) > 0; lineNumber++ )
+   {
+   Node *node;
+
+      line[ strcspn( line, "\n" ) ] = '\0';
+      if( line[ strspn( line, " \t" ) ] == '#' )
+      {
+         continue;
+      }
+
+      if( ( argc = tokenizer-> tokenize( tokenizer, line, &argv ) ) < 0 )
+      {
+         fail( "unbalanced quotes", NULL );
+      }
+      if( argc < 2 )
+      {
+         continue;
+      }
+      hashDeclaration( argc, argv );
+
+      if( strcmp( argv[ 1 ], "program" ) == 0 && argc == 4 )
+      {
+         free( root-> name );
+         free( root-> description );
+         root-> name = xstrdup( argv[ 2 ] );
+         root-> description = xstrdup( argv[ 3 ] );
+         root-> line = lineNumber;
+      }
+      else if( strcmp( argv[ 1 ], "prefix" ) == 0 && argc == 3 )
+      {
+         free( *prefix );
+         *prefix = xstrdup( argv[ 2 ] );
+      }
+      else if( strcmp( argv[ 1 ], "command" ) == 0 && ( argc == 4 || argc == 5 ) )
+      {
+         addCommand( root, argv[ 2 ], argv[ 3 ], argc == 5 ? argv[ 4 ] : NULL );
+      }
+      else if( strcmp( argv[ 1 ], "argument" ) == 0 && ( argc == 5 || ( argc == 6 && strcmp( argv[ 5 ], "required" ) == 0 ) ) )
+      {
+         if( ( node = findPath( root, argv[ 2 ] ) ) == NULL )
+         {
+            fail( "command not declared", argv[ 2 ] );
+         }
+         for( int a = 0; a < node-> argumentCount; a++ )
+         {
+            if( strcmp( node-> arguments[ a ].name, argv[ 3 ] ) == 0 )
+            {
+               fail( "argument declared twice", argv[ 3 ] );
+            }
+         }
+         node-> arguments = xrealloc( node-> arguments, sizeof( ArgumentSpec ) * ( size_t )( node-> argumentCount + 1 ) );
+         node-> arguments[ node-> argumentCount ].name = xstrdup( argv[ 3 ] );
+         node-> arguments[ node-> argumentCount ].description = xstrdup( argv[ 4 ] );
+         node-> arguments[ node-> argumentCount ].required = argc == 6;
+         node-> arguments[ node-> argumentCount ].line = lineNumber;
+         node-> argumentCount++;
+      }
+      else if( strcmp( argv[ 1 ], "flag" ) == 0 && argc == 6 && strlen( argv[ 4 ] ) == 1 )
+      {
+         if( ( node = findPath( root, argv[ 2 ] ) ) == NULL )
+         {
+            fail( "command not declared", argv[ 2 ] );
+         }
+         for( int f = 0; f < node-> flagCount; f++ )
+         {
+            if( strcmp( node-> flags[ f ].name, argv[ 3 ] ) == 0 )
+            {
+               fail( "flag declared twice", argv[ 3 ] );
+            }
+         }
+         node-> flags = xrealloc( node-> flags, sizeof( FlagSpec ) * ( size_t )( node-> flagCount + 1 ) );
+         node-> flags[ node-> flagCount ].name = xstrdup( argv[ 3 ] );
+         node-> flags[ node-> flagCount ].shortName = argv[ 4 ][ 0 ] != '-' ? argv[ 4 ][ 0 ] : '\0';
+         node-> flags[ node-> flagCount ].description = xstrdup( argv[ 5 ] );
+         node-> flags[ node-> flagCount ].line = lineNumber;
+         node-> flagCount++;
+      }
+      else
+      {
+         fail( "malformed line", argv[ 1 ] );
+      }
+   }
+
+   free( line );
+   tokenizer-> delete( &tokenizer );
+}
+
+
+int main( int argc, char *argv[] )
+{
+Node root = { 0 };
+Node **byId;
+char *prefix = NULL, *header, *guard;
+FILE *in, *source, *headerFile;
+int count = 0;
+
+   if( argc != 4 )
+   {
+      fprintf( stderr, "Usage: %s SPEC OUTPUT.c OUTPUT.h\n", argv[ 0 ] );
+      return 1;
+   }
+
+   specName = argv[ 1 ];
+   specBaseName = strrchr( specName, '/' ) != NULL ? strrchr( specName, '/' ) + 1 : specName;
+   if( ( in = fopen( argv[ 1 ], "r" ) ) == NULL )
+   {
+      fail( "cannot open", argv[ 1 ] );
+   }
+   root.path = xstrdup( "" );
+   parseSpec( in, &root, &prefix );
+   fclose( in );
+
+   if( root.name == NULL )
+   {
+      fail( "missing 'program NAME DESCRIPTION' line", NULL );
+   }
+   if( prefix == NULL )
+   {
+      prefix = xstrdup( root.name );
+   }
+
+   assignIds( &root, prefix, &count, NULL );
+   byId = xcalloc( ( size_t ) count, sizeof( Node * ) );
+   count = 0;
+   assignIds( &root, prefix, &count, byId );
+
+   header = strrchr( argv[ 3 ], '/' ) != NULL ? strrchr( argv[ 3 ], '/' ) + 1 : argv[ 3 ];
+   guard = makeIdentifier( header, "" );
+   checkIdentifiers( byId, count, prefix, guard );
+
+   if( ( source = fopen( argv[ 2 ], "w" ) ) == NULL || ( headerFile = fopen( argv[ 3 ], "w" ) ) == NULL )
+   {
+      fail( "cannot write output", NULL );
+   }
+   emitHeader( headerFile, byId, count, prefix, guard );
+   emitSource( source, byId, count, prefix, header );
+
+   if( fclose( headerFile ) != 0 || fclose( source ) != 0 )
+   {
+      fail( "cannot write output", NULL );
+   }
+
+   return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef LIBCLI_ALLOCATOR_H
+#define LIBCLI_ALLOCATOR_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+typedef struct AllocatorHooks
+{
+   void * ( *allocate )( void *, size_t );
+   void * ( *reallocate )( void *, void *, size_t, size_t );
+   void ( *release )( void *, void *, size_t );
+   void *userData;
+} AllocatorHooks_t;
+
+
+// Running counts of what an allocator handed out; reservedBytes is what it took from the system for that, which only
+// differs from liveBytes for arenas
+typedef struct AllocatorStats
+{
+   size_t allocations;
+   size_t releases;
+   size_t liveBytes;
+   size_t peakBytes;
+   size_t reservedBytes;
+} AllocatorStats_t;
+
+
+typedef struct Allocator
+{
+   void * ( *allocate )( const struct Allocator *, size_t );
+   void * ( *reallocate )( const struct Allocator *, void *, size_t, size_t );
+   char * ( *duplicate )( const struct Allocator *, const char * );
+   void ( *release )( const struct Allocator *, void *, size_t );
+   void ( *releaseString )( const struct Allocator *, char * );
+   bool ( *isArena )( const struct Allocator * );
+   void ( *getStats )( const struct Allocator *, AllocatorStats_t * );
+   void ( *delete )( struct Allocator ** );
+} Allocator_t;
+
+const Allocator_t * heapAllocator( void );
+Allocator_t * newAllocator( const AllocatorHooks_t * );
+Allocator_t * newArenaAllocator( size_t );
+
+#endif
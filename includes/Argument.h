@@ -3,18 +3,19 @@
 
 
 #include <stdbool.h>
+#include "Allocator.h"
+#include "MemoryReport.h"
 
 
 typedef struct Argument
 {
    const char * ( *getName )( const struct Argument * );
    const char * ( *getDescription )( const struct Argument * );
-   const char * ( *getValue )( const struct Argument * );
    bool ( *isRequired )( const struct Argument * );
-   void ( *setValue )( const struct Argument *, const char * );
+   void ( *measure )( const struct Argument *, CLIMemoryReport_t * );
    void ( *delete )( struct Argument ** );
 } Argument_t;
 
-Argument_t * newArgument( const char *, const char *, bool );
+Argument_t * newArgument( const Allocator_t *, const char *, const char *, bool );
 
 #endif
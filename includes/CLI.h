@@ -2,7 +2,11 @@
 #define LIBCLI_CLI_H
 
 
+#include <stdio.h>
+#include "Allocator.h"
 #include "Command.h"
+#include "MemoryReport.h"
+#include "Snapshot.h"
 
 
 #define CLI_SUCCESS                   0
@@ -14,17 +18,47 @@
 #define CLI_ERROR_CONTEXT_FAILED     -6
 
 
+typedef struct CLIBatchStats
+{
+   unsigned long lines;
+   unsigned long failed;
+   double seconds;
+} CLIBatchStats_t;
+
+
+typedef struct CLIParallelOptions
+{
+   int threads;
+   bool ordered;
+   void ( *onResult )( void *, unsigned long, int );
+   void *userData;
+} CLIParallelOptions_t;
+
+
 typedef struct CLI
 {
    int ( *addCommand )( const struct CLI *, const char *, const char *, int ( * )( const struct CommandContext * ) );
    int ( *addSubCommand )( const struct CLI *, const char *, const char *, const char *, int ( * )( const struct CommandContext * ) );
+   int ( *addLazyCommand )( const struct CLI *, const char *, const char *, const char *, int ( * )( const struct CommandContext * ), CLILoader_t, void * );
+   int ( *loadPlugins )( const struct CLI *, const char * );
    int ( *addArgument )( const struct CLI *, const char *, const char *, const char *, bool );
    int ( *addFlag )( const struct CLI *, const char *, const char *, char, const char * );
+   int ( *getArgumentId )( const struct CLI *, const char *, const char * );
+   int ( *getFlagId )( const struct CLI *, const char *, const char * );
+   int ( *reserve )( const struct CLI *, const char *, int, int, int );
+   int ( *freeze )( const struct CLI *, bool );
    int ( *parse )( const struct CLI *, int, char *[] );
+   int ( *parseTokens )( const struct CLI *, int, const char *const [] );
+   int ( *parseBatch )( const struct CLI *, FILE *, int, CLIBatchStats_t * );
+   int ( *parseBatchParallel )( const struct CLI *, FILE *, int, const CLIParallelOptions_t *, CLIBatchStats_t * );
+   int ( *serve )( const struct CLI *, const char *, int );
+   int ( *getMemoryReport )( const struct CLI *, CLIMemoryReport_t * );
+   int ( *saveSnapshot )( const struct CLI *, const char *, uint64_t, const CLIHandlerBinding_t *, int );
    void ( *delete )( struct CLI ** );
 } CLI_t;
 
 CLI_t * newCLI( const char * );
+CLI_t * newCLIWithAllocator( const char *, Allocator_t * );
 
 
 #endif
@@ -3,7 +3,16 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 #include "CommandContext.h"
+#include "MemoryReport.h"
+
+
+struct CLI;
+
+// Populates a command's subtree through the CLI it belongs to, given the command's path from the root
+typedef int ( *CLILoader_t )( const struct CLI *, const char *, void * );
 
 
 typedef struct Command
@@ -11,21 +20,35 @@ typedef struct Command
    int ( *addSubCommand )( struct Command *, struct Command * );
    int ( *addArgument )( const struct Command *, struct Argument * );
    int ( *addFlag )( const struct Command *, struct Flag * );
-   int ( *parse )( struct Command *, int, char *[] );
+   int ( *reserve )( const struct Command *, int, int, int );
+   int ( *parse )( struct Command *, int, const char *const [] );
+   int ( *execute )( struct Command *, int, const char *const [], FILE *, FILE * );
    void ( *delete )( struct Command ** );
    const char * ( *getName )( const struct Command * );
    const char * ( *getDescription )( const struct Command * );
-   const char * ( *getArgumentValue )( const struct Command *, const char * );
    Argument_t ** ( *getArguments )( const struct Command * );
    int ( *getArgumentCount )( const struct Command * );
    Flag_t ** ( *getFlags )( const struct Command * );
    int ( *getFlagCount )( const struct Command * );
    struct Command ** ( *getSubCommands )( const struct Command * );
    int ( *getSubCommandCount )( const struct Command * );
-   void ( *printHelp )( const struct Command * );
-   void ( *forEachSubCommand )( const struct Command *, bool( * )( struct Command * ) );
+   const char * ( *getSubCommandNameInOrder )( const struct Command *, int );
+   void ( *printHelp )( const struct Command *, FILE * );
+   void ( *forEachSubCommand )( const struct Command *, bool( * )( struct Command *, void * ), void * );
+   void ( *forEachSubCommandWithPrefix )( const struct Command *, const char *, size_t, bool( * )( struct Command *, void * ), void * );
+   void ( *forEachFlagWithPrefix )( const struct Command *, const char *, size_t, bool( * )( Flag_t *, void * ), void * );
+   struct Command * ( *findSubCommand )( const struct Command *, const char *, size_t );
+   int ( *freeze )( struct Command *, bool );
+   struct Command * ( *getParent )( const struct Command * );
+   int ( *( *getHandler )( const struct Command * ) )( const CommandContext_t * );
+   bool ( *isSorted )( const struct Command * );
+   int ( *findFlag )( const struct Command *, const char *, size_t );
+   int ( *findShortFlag )( const struct Command *, char );
+   int ( *findArgument )( const struct Command *, const char *, size_t );
+   void ( *measure )( const struct Command *, CLIMemoryReport_t * );
 } Command_t;
 
-Command_t * newCommand( const char *, const char *, int ( * )( const CommandContext_t * ) );
+Command_t * newCommand( const Allocator_t *, const char *, const char *, int ( * )( const CommandContext_t * ) );
+int setCommandLoader( Command_t *, CLILoader_t, const struct CLI *, void * );
 
 #endif
@@ -3,19 +3,41 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Allocator.h"
 #include "Argument.h"
 #include "Flag.h"
+#include "MemoryReport.h"
 
 struct Command;
 
 
+// The bit of a flag handle in the masks taken by anyFlags, allFlags and exactFlags, for handles below 64
+#define CLI_FLAG_BIT( id )   ( ( uint64_t ) 1 << ( id ) )
+
+
 typedef struct CommandContext
 {
    const char * ( *getArgument )( const struct CommandContext *, const char * );
    bool ( *getFlag )( const struct CommandContext *, const char * );
+   const char * ( *getArgumentById )( const struct CommandContext *, int );
+   bool ( *getFlagById )( const struct CommandContext *, int );
+   uint64_t ( *getFlagBits )( const struct CommandContext *, int );
+   bool ( *anyFlags )( const struct CommandContext *, uint64_t );
+   bool ( *allFlags )( const struct CommandContext *, uint64_t );
+   bool ( *exactFlags )( const struct CommandContext *, uint64_t );
+   FILE * ( *getOutput )( const struct CommandContext * );
+   FILE * ( *getErrorOutput )( const struct CommandContext * );
+   struct Command * ( *getCommand )( const struct CommandContext * );
+   void ( *setArgument )( struct CommandContext *, int, const char * );
+   void ( *setFlag )( struct CommandContext *, int );
    void ( *delete )( struct CommandContext ** );
 } CommandContext_t;
 
-CommandContext_t * newCommandContext( struct Command *, Argument_t **, int, Flag_t **, int );
+CommandContext_t * newCommandContext( const Allocator_t *, struct Command *, Argument_t **, int, Flag_t **, int, FILE *, FILE * );
+CommandContext_t * initCommandContext( void *, size_t, struct Command *, Argument_t **, int, Flag_t **, int, FILE *, FILE * );
+void getContextUsage( CLIMemoryUsage_t * );
 
 #endif 
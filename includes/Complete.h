@@ -0,0 +1,15 @@
+#ifndef LIBCLI_COMPLETE_H
+#define LIBCLI_COMPLETE_H
+
+
+#include <stdio.h>
+#include "Command.h"
+
+
+// The hidden first word that turns a command line into a completion request
+#define CLI_COMPLETE_COMMAND   "__complete"
+
+
+int completeCommand( const Command_t *, int, const char *const [], FILE * );
+
+#endif
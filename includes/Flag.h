@@ -3,6 +3,8 @@
 
 
 #include <stdbool.h>
+#include "Allocator.h"
+#include "MemoryReport.h"
 
 
 typedef struct Flag
@@ -10,11 +12,10 @@ typedef struct Flag
    const char * ( *getName )( const struct Flag * );
    const char * ( *getDescription )( const struct Flag * );
    char ( *getShortName )( const struct Flag * );
-   bool ( *isSet )( const struct Flag * );
-   void ( *set )( const struct Flag * );
+   void ( *measure )( const struct Flag *, CLIMemoryReport_t * );
    void ( *delete )( struct Flag ** );
 } Flag_t;
 
-Flag_t * newFlag( const char *, char, const char * );
+Flag_t * newFlag( const Allocator_t *, const char *, char, const char * );
 
 #endif 
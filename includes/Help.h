@@ -0,0 +1,14 @@
+#ifndef LIBCLI_HELP_H
+#define LIBCLI_HELP_H
+
+
+#include <stddef.h>
+#include <stdio.h>
+#include "Command.h"
+
+
+char * buildCommandPath( const Command_t * );
+char * formatHelp( const Command_t *, size_t * );
+void writeHelp( FILE *, const char *, size_t );
+
+#endif
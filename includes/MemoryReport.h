@@ -0,0 +1,37 @@
+#ifndef LIBCLI_MEMORYREPORT_H
+#define LIBCLI_MEMORYREPORT_H
+
+
+#include <stddef.h>
+#include "Allocator.h"
+
+
+typedef struct CLIMemoryUsage
+{
+   size_t bytes;
+   size_t allocations;
+} CLIMemoryUsage_t;
+
+
+// Where a tree's memory goes, in bytes as requested from its allocator; `allocator` adds what the allocator itself
+// handed out and reserved, rounding and arena blocks included
+typedef struct CLIMemoryReport
+{
+   CLIMemoryUsage_t commands;
+   CLIMemoryUsage_t arguments;
+   CLIMemoryUsage_t flags;
+   CLIMemoryUsage_t strings;
+   CLIMemoryUsage_t arrays;
+   size_t arraySlack;
+   CLIMemoryUsage_t indexes;
+   CLIMemoryUsage_t help;
+   CLIMemoryUsage_t total;
+   CLIMemoryUsage_t contexts;
+   AllocatorStats_t allocator;
+} CLIMemoryReport_t;
+
+void addMemoryUsage( CLIMemoryUsage_t *, size_t );
+void addStringUsage( CLIMemoryReport_t *, const char * );
+void sumMemoryReport( CLIMemoryReport_t * );
+
+#endif
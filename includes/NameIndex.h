@@ -0,0 +1,22 @@
+#ifndef LIBCLI_NAMEINDEX_H
+#define LIBCLI_NAMEINDEX_H
+
+
+#include <stddef.h>
+#include "Allocator.h"
+#include "MemoryReport.h"
+
+
+typedef struct NameIndex
+{
+   int ( *insert )( const struct NameIndex *, const char *, int );
+   int ( *reserve )( const struct NameIndex *, int );
+   int ( *find )( const struct NameIndex *, const char *, size_t );
+   int ( *getCount )( const struct NameIndex * );
+   void ( *measure )( const struct NameIndex *, CLIMemoryUsage_t * );
+   void ( *delete )( struct NameIndex ** );
+} NameIndex_t;
+
+NameIndex_t * newNameIndex( const Allocator_t * );
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LIBCLI_PARALLELBATCH_H
+#define LIBCLI_PARALLELBATCH_H
+
+
+#include <stdio.h>
+#include "CLI.h"
+
+
+int runParallelBatch( Command_t *, FILE *, int, const CLIParallelOptions_t *, CLIBatchStats_t * );
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LIBCLI_PARSER_H
+#define LIBCLI_PARSER_H
+
+
+#include <stdio.h>
+#include "Command.h"
+
+
+int executeCommand( Command_t *, int, const char *const [], FILE *, FILE * );
+
+#endif
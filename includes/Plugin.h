@@ -0,0 +1,22 @@
+#ifndef LIBCLI_PLUGIN_H
+#define LIBCLI_PLUGIN_H
+
+
+// The function a plugin library exports unless its manifest line names another; it has the CLILoader_t signature and
+// registers the plugin's subtree below the path it is given
+#define CLI_PLUGIN_ENTRY   "cliPluginLoad"
+
+
+struct CLI;
+
+
+// The libraries named by plugin manifests, opened on first use and closed when the set is deleted
+typedef struct Plugins
+{
+   int ( *load )( struct Plugins *, const struct CLI *, const char * );
+   void ( *delete )( struct Plugins ** );
+} Plugins_t;
+
+Plugins_t * newPlugins( void );
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef LIBCLI_SERVER_H
+#define LIBCLI_SERVER_H
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Command.h"
+
+
+#define SERVER_PROTOCOL_MAGIC   0x434c4931u
+#define SERVER_MAX_ARGC         65536u
+#define SERVER_MAX_REQUEST      ( 16u * 1024u * 1024u )
+
+
+// Requests carry argv as `size` bytes of `argc` consecutive NUL-terminated strings
+typedef struct ServerRequestHeader
+{
+   uint32_t magic;
+   uint32_t argc;
+   uint32_t size;
+} ServerRequestHeader_t;
+
+
+// Responses carry the handler's result followed by its captured output and error bytes
+typedef struct ServerResponseHeader
+{
+   uint32_t magic;
+   int32_t result;
+   uint32_t outputLength;
+   uint32_t errorLength;
+} ServerResponseHeader_t;
+
+
+int runServer( Command_t *, const char *, int );
+int clientRequest( const char *, int, const char *const [], FILE *, FILE *, int * );
+int connectCommand( int, const char *const [] );
+bool runConnect( int, char *[], int * );
+
+#endif
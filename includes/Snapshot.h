@@ -0,0 +1,36 @@
+#ifndef LIBCLI_SNAPSHOT_H
+#define LIBCLI_SNAPSHOT_H
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Command.h"
+#include "CommandContext.h"
+
+
+// Handlers cannot be stored in a file, so a snapshot records each by name: the same table, mapping the names to this
+// build's functions, is given when writing and when opening
+typedef struct CLIHandlerBinding
+{
+   const char *name;
+   int ( *handler )( const CommandContext_t * );
+} CLIHandlerBinding_t;
+
+
+// A tree mapped read-only from a snapshot file, parsed in place
+typedef struct CLISnapshot
+{
+   Command_t * ( *getRoot )( const struct CLISnapshot * );
+   int ( *parse )( const struct CLISnapshot *, int, char *[] );
+   int ( *parseTokens )( const struct CLISnapshot *, int, const char *const [] );
+   bool ( *verify )( const struct CLISnapshot * );
+   void ( *delete )( struct CLISnapshot ** );
+} CLISnapshot_t;
+
+// The tree identifier is the caller's name for the tree the snapshot was built from, such as a hash of its description;
+// a snapshot is only opened by a caller giving the same one
+int writeSnapshot( const Command_t *, const char *, uint64_t, const CLIHandlerBinding_t *, int );
+CLISnapshot_t * openSnapshot( const char *, uint64_t, const CLIHandlerBinding_t *, int );
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef LIBCLI_SOCKET_H
+#define LIBCLI_SOCKET_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+// Whole-buffer transfers on a stream socket, shared by the server and its client so that both frame messages alike
+bool readFull( int, void *, size_t );
+bool sendFull( int, const void *, size_t );
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef LIBCLI_STATICCOMMAND_H
+#define LIBCLI_STATICCOMMAND_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "Command.h"
+#include "CommandContext.h"
+#include "Argument.h"
+#include "Flag.h"
+
+
+// Commands, arguments and flags declared as `static const` tables. Each embeds the same interface as its runtime
+// counterpart, so the parser, help and batch code run over them unchanged, with nothing registered or allocated.
+// Subcommand lists must be sorted by name; lookups binary-search them.
+
+
+typedef struct StaticArgument
+{
+   Argument_t interface;
+   const char *name;
+   const char *description;
+   bool required;
+} StaticArgument_t;
+
+
+typedef struct StaticFlag
+{
+   Flag_t interface;
+   const char *name;
+   const char *description;
+   char shortName;
+} StaticFlag_t;
+
+
+typedef struct StaticCommand
+{
+   Command_t interface;
+   Command_t *parent;
+   const char *name;
+   const char *description;
+   int ( *handler )( const CommandContext_t * );
+   Command_t **subCommands;
+   int subCommandCount;
+   Argument_t **arguments;
+   int argumentCount;
+   Flag_t **flags;
+   int flagCount;
+   int ( *lookupSubCommand )( const char *, size_t );
+   int ( *lookupFlag )( const char *, size_t );
+} StaticCommand_t;
+
+
+const char * staticArgumentGetName( const Argument_t * );
+const char * staticArgumentGetDescription( const Argument_t * );
+bool staticArgumentIsRequired( const Argument_t * );
+void staticArgumentMeasure( const Argument_t *, CLIMemoryReport_t * );
+void staticArgumentDelete( Argument_t ** );
+
+const char * staticFlagGetName( const Flag_t * );
+const char * staticFlagGetDescription( const Flag_t * );
+char staticFlagGetShortName( const Flag_t * );
+void staticFlagMeasure( const Flag_t *, CLIMemoryReport_t * );
+void staticFlagDelete( Flag_t ** );
+
+int staticCommandAddSubCommand( Command_t *, Command_t * );
+int staticCommandAddArgument( const Command_t *, Argument_t * );
+int staticCommandAddFlag( const Command_t *, Flag_t * );
+int staticCommandReserve( const Command_t *, int, int, int );
+int staticCommandParse( Command_t *, int, const char *const [] );
+int staticCommandExecute( Command_t *, int, const char *const [], FILE *, FILE * );
+void staticCommandDelete( Command_t ** );
+const char * staticCommandGetName( const Command_t * );
+const char * staticCommandGetDescription( const Command_t * );
+Argument_t ** staticCommandGetArguments( const Command_t * );
+int staticCommandGetArgumentCount( const Command_t * );
+Flag_t ** staticCommandGetFlags( const Command_t * );
+int staticCommandGetFlagCount( const Command_t * );
+Command_t ** staticCommandGetSubCommands( const Command_t * );
+int staticCommandGetSubCommandCount( const Command_t * );
+const char * staticCommandGetSubCommandNameInOrder( const Command_t *, int );
+void staticCommandPrintHelp( const Command_t *, FILE * );
+void staticCommandForEachSubCommand( const Command_t *, bool ( * )( Command_t *, void * ), void * );
+void staticCommandForEachSubCommandWithPrefix( const Command_t *, const char *, size_t, bool ( * )( Command_t *, void * ), void * );
+void staticCommandForEachFlagWithPrefix( const Command_t *, const char *, size_t, bool ( * )( Flag_t *, void * ), void * );
+Command_t * staticCommandFindSubCommand( const Command_t *, const char *, size_t );
+int staticCommandFreeze( Command_t *, bool );
+Command_t * staticCommandGetParent( const Command_t * );
+int ( *staticCommandGetHandler( const Command_t * ) )( const CommandContext_t * );
+bool staticCommandIsSorted( const Command_t * );
+int staticCommandFindFlag( const Command_t *, const char *, size_t );
+int staticCommandFindShortFlag( const Command_t *, char );
+int staticCommandFindArgument( const Command_t *, const char *, size_t );
+void staticCommandMeasure( const Command_t *, CLIMemoryReport_t * );
+
+int checkStatic( const StaticCommand_t * );
+int parseStatic( const StaticCommand_t *, int, char *[] );
+
+
+// A reference to a static object as its interface, for subcommand, argument and flag lists and for parents
+#define CLI_STATIC_REF( object )   ( ( void * ) &( object ).interface )
+
+// An array of references and its length, or no list at all
+#define CLI_STATIC_LIST( array )   ( ( void * )( array ) ), ( int )( sizeof( array ) / sizeof( ( array )[ 0 ] ) )
+#define CLI_STATIC_NONE            NULL, 0
+
+#define CLI_STATIC_ARGUMENT( name, description, required ) \
+   { { staticArgumentGetName, staticArgumentGetDescription, staticArgumentIsRequired, staticArgumentMeasure, staticArgumentDelete }, name, description, required }
+
+#define CLI_STATIC_FLAG( name, shortName, description ) \
+   { { staticFlagGetName, staticFlagGetDescription, staticFlagGetShortName, staticFlagMeasure, staticFlagDelete }, name, description, shortName }
+
+// The interface part of a static command, shared by the two command macros below
+#define CLI_STATIC_COMMAND_INTERFACE \
+   { \
+      .addSubCommand = staticCommandAddSubCommand, .addArgument = staticCommandAddArgument, .addFlag = staticCommandAddFlag, \
+      .reserve = staticCommandReserve, .parse = staticCommandParse, .execute = staticCommandExecute, .delete = staticCommandDelete, \
+      .getName = staticCommandGetName, .getDescription = staticCommandGetDescription, .getArguments = staticCommandGetArguments, \
+      .getArgumentCount = staticCommandGetArgumentCount, .getFlags = staticCommandGetFlags, .getFlagCount = staticCommandGetFlagCount, \
+      .getSubCommands = staticCommandGetSubCommands, .getSubCommandCount = staticCommandGetSubCommandCount, \
+      .getSubCommandNameInOrder = staticCommandGetSubCommandNameInOrder, \
+      .printHelp = staticCommandPrintHelp, .forEachSubCommand = staticCommandForEachSubCommand, \
+      .forEachSubCommandWithPrefix = staticCommandForEachSubCommandWithPrefix, .forEachFlagWithPrefix = staticCommandForEachFlagWithPrefix, \
+      .findSubCommand = staticCommandFindSubCommand, .freeze = staticCommandFreeze, .getParent = staticCommandGetParent, \
+      .getHandler = staticCommandGetHandler, .isSorted = staticCommandIsSorted, .findFlag = staticCommandFindFlag, \
+      .findShortFlag = staticCommandFindShortFlag, .findArgument = staticCommandFindArgument, \
+      .measure = staticCommandMeasure \
+   }
+
+// parent is NULL for the root, otherwise CLI_STATIC_REF of the parent, which may need a tentative definition first;
+// subCommands, arguments and flags are each CLI_STATIC_LIST( array ) or CLI_STATIC_NONE
+#define CLI_STATIC_COMMAND( parent, name, description, handler, subCommands, arguments, flags ) \
+   { CLI_STATIC_COMMAND_INTERFACE, parent, name, description, handler, subCommands, arguments, flags, NULL, NULL }
+
+// As CLI_STATIC_COMMAND, with functions mapping a subcommand or long flag name to its position in the list, or -1,
+// used instead of searching the lists; cligen generates them as perfect hashes
+#define CLI_STATIC_COMMAND_LOOKUP( parent, name, description, handler, subCommands, arguments, flags, lookupSubCommand, lookupFlag ) \
+   { CLI_STATIC_COMMAND_INTERFACE, parent, name, description, handler, subCommands, arguments, flags, lookupSubCommand, lookupFlag }
+
+#endif
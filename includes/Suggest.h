@@ -0,0 +1,14 @@
+#ifndef LIBCLI_SUGGEST_H
+#define LIBCLI_SUGGEST_H
+
+
+#include "Command.h"
+
+
+// The most names offered for one mistyped token
+#define SUGGEST_LIMIT   5
+
+
+int findSuggestions( const Command_t *, const char *, const char *[], int );
+
+#endif
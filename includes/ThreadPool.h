@@ -0,0 +1,17 @@
+#ifndef LIBCLI_THREADPOOL_H
+#define LIBCLI_THREADPOOL_H
+
+
+#include <stddef.h>
+
+
+typedef struct ThreadPool
+{
+   int ( *run )( const struct ThreadPool *, size_t, void ( * )( void *, int, size_t ), void * );
+   int ( *getWorkerCount )( const struct ThreadPool * );
+   void ( *delete )( struct ThreadPool ** );
+} ThreadPool_t;
+
+ThreadPool_t * newThreadPool( int );
+
+#endif
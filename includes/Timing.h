@@ -0,0 +1,46 @@
+#ifndef LIBCLI_TIMING_H
+#define LIBCLI_TIMING_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Command.h"
+
+
+typedef enum
+{
+   TIMING_REGISTRATION,
+   TIMING_RESOLVE,
+   TIMING_CONTEXT,
+   TIMING_ARGUMENTS,
+   TIMING_HANDLER,
+   TIMING_HELP,
+   TIMING_TOTAL,
+   TIMING_PHASE_COUNT
+} TimingPhase_t;
+
+
+// One dispatch being timed: each lap charges the time since the previous one to a phase
+typedef struct
+{
+   const Command_t *command;
+   uint64_t start;
+   uint64_t mark;
+   uint64_t phases[ TIMING_PHASE_COUNT ];
+   unsigned laps;
+} TimingSample_t;
+
+void enableTiming( bool );
+void dumpTiming( FILE * );
+void resetTiming( void );
+
+void loadTimingEnvironment( void );
+bool isTimingEnabled( void );
+uint64_t timingNow( void );
+void startSample( TimingSample_t *, const Command_t * );
+void lapSample( TimingSample_t *, TimingPhase_t );
+void recordSample( TimingSample_t * );
+void recordTiming( const Command_t *, TimingPhase_t, uint64_t );
+
+#endif
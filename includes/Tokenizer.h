@@ -0,0 +1,13 @@
+#ifndef LIBCLI_TOKENIZER_H
+#define LIBCLI_TOKENIZER_H
+
+
+typedef struct Tokenizer
+{
+   int ( *tokenize )( const struct Tokenizer *, char *, const char *const ** );
+   void ( *delete )( struct Tokenizer ** );
+} Tokenizer_t;
+
+Tokenizer_t * newTokenizer( const char * );
+
+#endif
@@ -0,0 +1,26 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "CLI.h"
+
+
+// A host with no commands of its own: everything comes from the manifest, named by CLI_PLUGINS or found in the
+// current directory
+int main( int argc, char *argv[] )
+{
+const char *manifest = getenv( "CLI_PLUGINS" ) != NULL ? getenv( "CLI_PLUGINS" ) : "example.manifest";
+CLI_t *cli;
+int result;
+
+   if( ( cli = newCLI( "Plugin host" ) ) == NULL )
+   {
+      return EXIT_FAILURE;
+   }
+
+   if( ( result = cli-> loadPlugins( cli, manifest ) ) == CLI_SUCCESS )
+   {
+      result = cli-> parse( cli, argc, argv );
+   }
+   cli-> delete( &cli );
+
+   return result == CLI_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <string.h>
+#include "CLI.h"
+#include "CommandContext.h"
+
+
+int cliPluginLoad( const CLI_t *, const char *, void * );
+int cliPluginLoadMore( const CLI_t *, const char *, void * );
+
+
+static int countHandler( const CommandContext_t *context )
+{
+const char *text = context-> getArgument( context, "text" );
+
+   fprintf( context-> getOutput( context ), "%zu\n", text != NULL ? strlen( text ) : 0 );
+
+   return CLI_SUCCESS;
+}
+
+
+static int upperHandler( const CommandContext_t *context )
+{
+FILE *output = context-> getOutput( context );
+
+   for( const char *c = context-> getArgument( context, "text" ); *c != '\0'; c++ )
+   {
+      fputc( *c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c, output );
+   }
+   fputc( '\n', output );
+
+   return CLI_SUCCESS;
+}
+
+
+// Registers below whatever path the manifest placed the plugin at
+int cliPluginLoad( const CLI_t *cli, const char *path, void *userData )
+{
+char command[ 256 ];
+int result;
+
+   ( void ) userData;
+
+   snprintf( command, sizeof( command ), "%s count", path );
+   if( ( result = cli-> addSubCommand( cli, path, "count", "Print the length of a text", countHandler ) ) != CLI_SUCCESS )
+   {
+      return result;
+   }
+
+   return cli-> addArgument( cli, command, "text", "Text to measure", true );
+}
+
+
+int cliPluginLoadMore( const CLI_t *cli, const char *path, void *userData )
+{
+char command[ 256 ];
+int result;
+
+   ( void ) userData;
+
+   snprintf( command, sizeof( command ), "%s upper", path );
+   if( ( result = cli-> addSubCommand( cli, path, "upper", "Print a text in upper case", upperHandler ) ) != CLI_SUCCESS )
+   {
+      return result;
+   }
+
+   return cli-> addArgument( cli, command, "text", "Text to convert", true );
+}